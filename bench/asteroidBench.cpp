@@ -0,0 +1,147 @@
+// asteroidBench.cpp
+// AsteroidBelt frame time vs asteroid count: CPU time to submit update() +
+// draw() (should not grow with N), GPU time of the orbit pass and draws, and
+// the whole frame up to glFinish. Renders into a hidden 1280x720 window with
+// the camera where main.cpp starts it.
+// Build from the project root:
+//   g++ -O2 -std=c++17 bench/asteroidBench.cpp src/AsteroidBelt.cpp -lglfw -lGLEW -lGL -o asteroidBench
+// Run: ./asteroidBench [frames] [maxCount]
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include "../src/AsteroidBelt.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+// Same steps as createShaderProgram / createFeedbackProgram in main.cpp.
+static GLuint compileFile(GLenum type, const char* path) {
+    std::ifstream file(path);
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string source = buffer.str();
+    const char* text = source.c_str();
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &text, nullptr);
+    glCompileShader(shader);
+    GLint ok = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        char log[512];
+        glGetShaderInfoLog(shader, 512, nullptr, log);
+        fprintf(stderr, "%s: %s\n", path, log);
+    }
+    return shader;
+}
+
+static GLuint linkProgram(const char* vertPath, const char* fragPath, const char* feedbackVarying) {
+    GLuint program = glCreateProgram();
+    GLuint vs = compileFile(GL_VERTEX_SHADER, vertPath);
+    GLuint fs = fragPath ? compileFile(GL_FRAGMENT_SHADER, fragPath) : 0;
+    glAttachShader(program, vs);
+    if (fs) glAttachShader(program, fs);
+    if (feedbackVarying)
+        glTransformFeedbackVaryings(program, 1, &feedbackVarying, GL_INTERLEAVED_ATTRIBS);
+    glLinkProgram(program);
+    GLint ok = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        char log[512];
+        glGetProgramInfoLog(program, 512, nullptr, log);
+        fprintf(stderr, "link %s: %s\n", vertPath, log);
+    }
+    glDeleteShader(vs);
+    if (fs) glDeleteShader(fs);
+    return program;
+}
+
+int main(int argc, char** argv) {
+    int frames = (argc > 1) ? atoi(argv[1]) : 200;
+    size_t maxCount = (argc > 2) ? (size_t)atoll(argv[2]) : 1000000;
+    if (frames < 1) frames = 1;
+
+    if (!glfwInit()) {
+        fprintf(stderr, "glfwInit failed\n");
+        return 1;
+    }
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    const int width = 1280, height = 720;
+    GLFWwindow* window = glfwCreateWindow(width, height, "asteroidBench", nullptr, nullptr);
+    if (!window) {
+        fprintf(stderr, "cannot create a window\n");
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+    glewExperimental = true;
+    if (glewInit() != GLEW_OK) {
+        fprintf(stderr, "glewInit failed\n");
+        return 1;
+    }
+
+    GLuint orbitProgram = linkProgram("shaders/asteroidOrbit_vertex.glsl", nullptr, "Center");
+    GLuint drawProgram = linkProgram("shaders/asteroid_vertex.glsl", "shaders/asteroid_fragment.glsl", nullptr);
+    glUseProgram(drawProgram);
+    glUniform3f(glGetUniformLocation(drawProgram, "lightPos1"), 10.0f, 10.0f, 10.0f);
+    glUniform3f(glGetUniformLocation(drawProgram, "lightColor1"), 1.0f, 1.0f, 1.0f);
+    glUniform3f(glGetUniformLocation(drawProgram, "lightPos2"), 0.0f, 8.0f, 0.0f);
+    glUniform3f(glGetUniformLocation(drawProgram, "lightColor2"), 1.0f, 1.0f, 1.0f);
+
+    glm::vec3 cameraPos(0.0f, 1.0f, 10.0f);
+    glm::mat4 view = glm::lookAt(cameraPos, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)width / height, 0.1f, 100.0f);
+    LodView lodView;
+    lodView.set(cameraPos, glm::radians(45.0f), height);
+
+    glViewport(0, 0, width, height);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    GLuint query = 0;
+    glGenQueries(1, &query);
+
+    printf("%d frames at %dx%d (%s)\n", frames, width, height, (const char*)glGetString(GL_RENDERER));
+    printf("  asteroids   init ms   submit us    GPU ms   frame ms\n");
+    for (size_t count = 1000; count <= maxCount; count *= 10) {
+        AsteroidBelt belt;
+        auto t0 = std::chrono::steady_clock::now();
+        belt.init(orbitProgram, drawProgram, count);
+        glFinish();
+        double initMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+        double submit = 0.0, gpu = 0.0, frame = 0.0;
+        for (int f = -10; f < frames; ++f) {   // 10 warm-up frames
+            float simDays = f * (1.0f / 60.0f);
+            auto start = std::chrono::steady_clock::now();
+            glBeginQuery(GL_TIME_ELAPSED, query);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            belt.update(simDays, view, projection, lodView);
+            belt.draw(simDays, view, projection);
+            glEndQuery(GL_TIME_ELAPSED);
+            auto submitted = std::chrono::steady_clock::now();
+            glFinish();
+            auto finished = std::chrono::steady_clock::now();
+            GLuint64 ns = 0;
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &ns);
+            if (f < 0) continue;
+            submit += std::chrono::duration<double, std::micro>(submitted - start).count();
+            frame += std::chrono::duration<double, std::milli>(finished - start).count();
+            gpu += ns * 1e-6;
+        }
+        printf("  %9zu  %8.1f  %10.1f  %8.3f  %9.3f\n", count, initMs,
+               submit / frames, gpu / frames, frame / frames);
+        belt.release();
+    }
+
+    glDeleteQueries(1, &query);
+    glDeleteProgram(orbitProgram);
+    glDeleteProgram(drawProgram);
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,92 @@
+// objLoaderBench.cpp
+// Compares the stdio loadOBJ against the memory-mapped loadOBJFast.
+// Build from the project root:
+//   g++ -O2 -std=c++17 bench/objLoaderBench.cpp -o objBench
+// Run: ./objBench [path.obj] [iterations]
+#include "../OBJloader.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+typedef bool (*LoaderFn)(const char*, std::vector<glm::vec3>&, std::vector<glm::vec3>&,
+                         std::vector<glm::vec2>&, std::vector<unsigned int>&);
+
+struct MeshOut {
+    std::vector<glm::vec3> positions, normals;
+    std::vector<glm::vec2> uvs;
+    std::vector<unsigned int> indices;
+};
+
+// Best-of-N wall time in seconds; the last run's output is kept for comparison.
+static double timeLoader(LoaderFn fn, const char* path, int iterations, MeshOut& out) {
+    double best = 1e30;
+    for (int i = 0; i < iterations; ++i) {
+        out = MeshOut();
+        auto t0 = std::chrono::steady_clock::now();
+        if (!fn(path, out.positions, out.normals, out.uvs, out.indices)) return -1.0;
+        auto t1 = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double>(t1 - t0).count());
+    }
+    return best;
+}
+
+static bool loadFast(const char* path, std::vector<glm::vec3>& p, std::vector<glm::vec3>& n,
+                     std::vector<glm::vec2>& uv, std::vector<unsigned int>& idx) {
+    return loadOBJFast(path, p, n, uv, idx);
+}
+
+// Largest per-component difference between corners of the same index.
+template <typename Vec>
+static float maxDiff(const std::vector<Vec>& a, const std::vector<Vec>& b) {
+    float d = 0.0f;
+    for (size_t i = 0; i < a.size() && i < b.size(); ++i)
+        for (int k = 0; k < Vec::length(); ++k) d = std::max(d, std::fabs(a[i][k] - b[i][k]));
+    return d;
+}
+
+// Both loaders triangulate alike and emit corners in file order, so the
+// outputs must agree corner by corner; the float parsers may differ in the
+// last bit.
+const float TOLERANCE = 1e-4f;
+
+int main(int argc, char** argv) {
+    const char* path = (argc > 1) ? argv[1] : "models/spacestation.obj";
+    int iterations = (argc > 2) ? std::max(1, atoi(argv[2])) : 5;
+
+    MappedFile probe(path);
+    if (!probe.isOpen()) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return 1;
+    }
+    double mb = probe.size() / (1024.0 * 1024.0);
+    probe.close();
+
+    MeshOut ref, fast;
+    double tRef  = timeLoader(loadOBJ, path, iterations, ref);
+    double tFast = timeLoader(loadFast, path, iterations, fast);
+    if (tRef < 0.0 || tFast < 0.0) {
+        fprintf(stderr, "loader failed on %s\n", path);
+        return 1;
+    }
+
+    printf("%s: %.2f MB, best of %d\n", path, mb, iterations);
+    printf("  loadOBJ     %8.2f ms  %8.1f MB/s\n", tRef * 1e3, mb / tRef);
+    printf("  loadOBJFast %8.2f ms  %8.1f MB/s  (%.1fx)\n", tFast * 1e3, mb / tFast, tRef / tFast);
+
+    float dPos = maxDiff(ref.positions, fast.positions);
+    float dNormal = maxDiff(ref.normals, fast.normals);
+    float dUv = maxDiff(ref.uvs, fast.uvs);
+    bool same = ref.positions.size() == fast.positions.size() &&
+                ref.normals.size() == fast.normals.size() &&
+                ref.uvs.size() == fast.uvs.size() &&
+                dPos <= TOLERANCE && dNormal <= TOLERANCE && dUv <= TOLERANCE;
+    printf("  corners %zu/%zu, normals %zu/%zu, uvs %zu/%zu, max |dpos| %g, max |dnormal| %g, max |duv| %g\n",
+           ref.positions.size(), fast.positions.size(),
+           ref.normals.size(), fast.normals.size(),
+           ref.uvs.size(), fast.uvs.size(), dPos, dNormal, dUv);
+    if (!same)
+        printf("  MISMATCH: loadOBJFast differs from loadOBJ (tolerance %g)\n", TOLERANCE);
+    return same ? 0 : 2;
+}
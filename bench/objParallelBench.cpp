@@ -0,0 +1,68 @@
+// objParallelBench.cpp
+// Scaling of loadOBJParallel from 1 to N threads, checked against loadOBJFast.
+// Build from the project root:
+//   g++ -O2 -std=c++17 -pthread bench/objParallelBench.cpp -o objParallelBench
+// Run: ./objParallelBench [path.obj] [maxThreads] [iterations]
+#include "../OBJloader.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+struct MeshOut {
+    std::vector<glm::vec3> positions, normals;
+    std::vector<glm::vec2> uvs;
+    std::vector<unsigned int> indices;
+};
+
+static bool sameMesh(const MeshOut& a, const MeshOut& b) {
+    return a.positions == b.positions && a.normals == b.normals && a.uvs == b.uvs;
+}
+
+int main(int argc, char** argv) {
+    const char* path = (argc > 1) ? argv[1] : "models/spacestation.obj";
+    unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    unsigned maxThreads = (argc > 2) ? (unsigned)std::max(1, atoi(argv[2])) : hw;
+    int iterations = (argc > 3) ? std::max(1, atoi(argv[3])) : 5;
+
+    MappedFile probe(path);
+    if (!probe.isOpen()) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return 1;
+    }
+    double mb = probe.size() / (1024.0 * 1024.0);
+    probe.close();
+
+    MeshOut ref;
+    if (!loadOBJFast(path, ref.positions, ref.normals, ref.uvs, ref.indices)) {
+        fprintf(stderr, "loadOBJFast failed on %s\n", path);
+        return 1;
+    }
+
+    printf("%s: %.2f MB, %zu corners, best of %d (%u hardware threads)\n",
+           path, mb, ref.positions.size(), iterations, hw);
+    printf("  threads        ms      MB/s   speedup\n");
+
+    double base = 0.0;
+    bool allSame = true;
+    for (unsigned t = 1; t <= maxThreads; ++t) {
+        double best = 1e30;
+        MeshOut out;
+        for (int i = 0; i < iterations; ++i) {
+            out = MeshOut();
+            auto t0 = std::chrono::steady_clock::now();
+            if (!loadOBJParallel(path, out.positions, out.normals, out.uvs, out.indices, t)) {
+                fprintf(stderr, "loadOBJParallel failed with %u threads\n", t);
+                return 1;
+            }
+            auto t1 = std::chrono::steady_clock::now();
+            best = std::min(best, std::chrono::duration<double>(t1 - t0).count());
+        }
+        if (t == 1) base = best;
+        bool same = sameMesh(ref, out);
+        allSame = allSame && same;
+        printf("  %7u  %8.2f  %8.1f  %7.2fx%s\n", t, best * 1e3, mb / best, base / best,
+               same ? "" : "  MISMATCH");
+    }
+    return allSame ? 0 : 2;
+}
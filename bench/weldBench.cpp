@@ -0,0 +1,94 @@
+// weldBench.cpp
+// Old unordered_map + XOR-hash welding vs weldVertices (open addressing).
+// Build from the project root:
+//   g++ -O2 -std=c++17 bench/weldBench.cpp -o weldBench
+// Run: ./weldBench [path.obj] [iterations]
+#include "../OBJloader.h"
+#include "../src/VertexWelder.h"
+#include <unordered_map>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+// The welding loadSphereModel/loadModelToBuffers used before VertexWelder.h.
+static size_t weldUnorderedMap(const std::vector<glm::vec3>& positions,
+                               const std::vector<glm::vec3>& normals,
+                               const std::vector<glm::vec2>& uvs,
+                               std::vector<Vertex>& vertices,
+                               std::vector<unsigned int>& indices,
+                               size_t& buckets, size_t& maxBucket) {
+    struct Key {
+        glm::vec3 position;
+        glm::vec3 normal;
+        glm::vec2 texCoord;
+        bool operator==(const Key& o) const {
+            return position == o.position && normal == o.normal && texCoord == o.texCoord;
+        }
+    };
+    struct Hasher {
+        size_t operator()(const Key& v) const {
+            size_t h1 = std::hash<float>()(v.position.x) ^ std::hash<float>()(v.position.y) ^ std::hash<float>()(v.position.z);
+            size_t h2 = std::hash<float>()(v.normal.x) ^ std::hash<float>()(v.normal.y) ^ std::hash<float>()(v.normal.z);
+            size_t h3 = std::hash<float>()(v.texCoord.x) ^ std::hash<float>()(v.texCoord.y);
+            return h1 ^ h2 ^ h3;
+        }
+    };
+    std::unordered_map<Key, unsigned int, Hasher> vertexToIndex;
+    vertices.clear();
+    indices.clear();
+    for (size_t i = 0; i < positions.size(); ++i) {
+        Key k = { positions[i],
+                  (i < normals.size()) ? normals[i] : glm::vec3(0.0f),
+                  (i < uvs.size()) ? uvs[i] : glm::vec2(0.0f) };
+        auto it = vertexToIndex.find(k);
+        if (it != vertexToIndex.end()) {
+            indices.push_back(it->second);
+        } else {
+            vertices.push_back({ k.position, k.texCoord, k.normal });
+            unsigned int idx = (unsigned int)vertices.size() - 1;
+            vertexToIndex[k] = idx;
+            indices.push_back(idx);
+        }
+    }
+    buckets = vertexToIndex.bucket_count();
+    maxBucket = 0;
+    for (size_t b = 0; b < buckets; ++b) maxBucket = std::max(maxBucket, vertexToIndex.bucket_size(b));
+    return vertices.size();
+}
+
+int main(int argc, char** argv) {
+    const char* path = (argc > 1) ? argv[1] : "models/spacestation.obj";
+    int iterations = (argc > 2) ? std::max(1, atoi(argv[2])) : 5;
+
+    std::vector<glm::vec3> positions, normals;
+    std::vector<glm::vec2> uvs;
+    std::vector<unsigned int> unused;
+    size_t triangles = 0;
+    if (!loadOBJFast(path, positions, normals, uvs, unused, &triangles)) {
+        fprintf(stderr, "cannot load %s\n", path);
+        return 1;
+    }
+
+    std::vector<Vertex> vRef, vNew;
+    std::vector<unsigned int> iRef, iNew;
+    double tRef = 1e30, tNew = 1e30;
+    size_t buckets = 0, maxBucket = 0;
+    WeldStats stats;
+    for (int it = 0; it < iterations; ++it) {
+        auto t0 = std::chrono::steady_clock::now();
+        weldUnorderedMap(positions, normals, uvs, vRef, iRef, buckets, maxBucket);
+        auto t1 = std::chrono::steady_clock::now();
+        tRef = std::min(tRef, std::chrono::duration<double, std::milli>(t1 - t0).count());
+
+        stats = weldVertices(positions, normals, uvs, triangles, vNew, iNew);
+        tNew = std::min(tNew, stats.milliseconds);
+    }
+
+    bool same = iRef == iNew && vRef.size() == vNew.size();
+    printf("%s: %zu triangles, %zu corners, best of %d\n", path, triangles, positions.size(), iterations);
+    printf("  unordered_map  %8.2f ms  %zu vertices  (%zu buckets, longest chain %zu)\n",
+           tRef, vRef.size(), buckets, maxBucket);
+    printf("  weldVertices   %8.2f ms  %zu vertices  (%zu slots)  %.1fx%s\n",
+           tNew, stats.vertices, stats.tableSlots, tRef / tNew, same ? "" : "  MISMATCH");
+    return same ? 0 : 2;
+}
@@ -0,0 +1,47 @@
+#version 330 core
+// Orbit pass (AsteroidBelt::update): one point per asteroid with the
+// rasterizer discarded; Center is captured by transform feedback and read
+// per instance by asteroid_vertex.glsl.
+layout(location = 0) in vec4 aOrbit0;   // semi-major axis, eccentricity, inclination, ascending node
+layout(location = 1) in vec4 aOrbit1;   // argument of periapsis, mean anomaly at day 0, mean motion (rad/day), radius
+
+uniform float simDays;
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 cameraPos;
+uniform float pixelsPerUnit;    // LodView
+uniform vec3 lodPixels;         // projected radius for LOD0, LOD1, and below which to cull
+
+out vec4 Center;                // world position, LOD (-1 = culled)
+
+vec3 rotateX(vec3 p, float a) { float c = cos(a), s = sin(a); return vec3(p.x, c * p.y - s * p.z, s * p.y + c * p.z); }
+vec3 rotateY(vec3 p, float a) { float c = cos(a), s = sin(a); return vec3(c * p.x + s * p.z, p.y, -s * p.x + c * p.z); }
+
+void main() {
+    float a = aOrbit0.x, e = aOrbit0.y;
+
+    // Kepler's equation E - e sin E = M; Newton converges in a few steps for small e
+    float M = mod(aOrbit1.y + aOrbit1.z * simDays, 6.2831853);
+    float E = M + e * sin(M);
+    for (int i = 0; i < 3; ++i)
+        E -= (E - e * sin(E) - M) / (1.0 - e * cos(E));
+
+    // orbital plane = XZ with periapsis on +X, turning like the planets (+X towards -Z)
+    vec3 p = vec3(a * (cos(E) - e), 0.0, -a * sqrt(1.0 - e * e) * sin(E));
+    p = rotateY(p, aOrbit1.x);  // argument of periapsis
+    p = rotateX(p, aOrbit0.z);  // inclination
+    p = rotateY(p, aOrbit0.w);  // ascending node
+
+    // bounding sphere against the side planes and the camera plane
+    float r = aOrbit1.w;
+    vec3 v = (view * vec4(p, 1.0)).xyz;
+    vec2 s = vec2(projection[0][0], projection[1][1]);
+    bool outside = v.z > r ||
+                   abs(v.x) * s.x + v.z > r * sqrt(s.x * s.x + 1.0) ||
+                   abs(v.y) * s.y + v.z > r * sqrt(s.y * s.y + 1.0);
+
+    float pixels = r * pixelsPerUnit / max(length(p - cameraPos), r);
+    float lod = pixels >= lodPixels.x ? 0.0 : (pixels >= lodPixels.y ? 1.0 : 2.0);
+    Center = vec4(p, (outside || pixels < lodPixels.z) ? -1.0 : lod);
+    gl_Position = vec4(0.0);
+}
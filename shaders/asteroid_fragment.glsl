@@ -0,0 +1,20 @@
+#version 330 core
+// Asteroids: diffuse from both lights as in fragmentShader.glsl, no shadows.
+in vec3 FragPos;
+in vec3 Normal;
+flat in vec3 Tint;
+
+out vec4 FragColor;
+
+uniform vec3 lightPos1;
+uniform vec3 lightColor1;
+uniform vec3 lightPos2;
+uniform vec3 lightColor2;
+
+void main() {
+    vec3 N = normalize(Normal);
+    float diff1 = max(dot(N, normalize(lightPos1 - FragPos)), 0.0);
+    float diff2 = max(dot(N, normalize(lightPos2 - FragPos)), 0.0);
+    vec3 ambient = 0.05 * (lightColor1 + lightColor2);
+    FragColor = vec4((ambient + 1.5 * diff1 * lightColor1 + 1.5 * diff2 * lightColor2) * Tint, 1.0);
+}
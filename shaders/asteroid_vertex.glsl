@@ -0,0 +1,56 @@
+#version 330 core
+// One LOD of the asteroid belt (AsteroidBelt::draw), instanced over every
+// asteroid: instances the orbit pass put in another band, or culled,
+// collapse outside the clip volume before rasterization.
+layout(location = 0) in vec3 aPos;      // rock mesh, unit bounding radius
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec4 aCenter;   // per instance: world position, LOD (-1 = culled)
+layout(location = 3) in vec4 aOrbit1;   // per instance: w = radius
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform float simDays;
+uniform int lod;
+
+out vec3 FragPos;
+out vec3 Normal;
+flat out vec3 Tint;
+
+// spin axis, rate, shape and colour derive from the asteroid's index
+uint hash(uint x) {
+    x ^= x >> 16; x *= 0x7feb352du;
+    x ^= x >> 15; x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+float rand(uint id, uint k) { return float(hash(id * 8u + k) & 0xffffu) / 65535.0; }
+
+mat3 rotation(vec3 axis, float angle) {
+    float c = cos(angle), s = sin(angle);
+    vec3 t = (1.0 - c) * axis;
+    return mat3(t.x * axis + vec3(c, s * axis.z, -s * axis.y),
+                t.y * axis + vec3(-s * axis.z, c, s * axis.x),
+                t.z * axis + vec3(s * axis.y, -s * axis.x, c));
+}
+
+void main() {
+    if (int(aCenter.w) != lod) {
+        gl_Position = vec4(0.0, 0.0, 2.0, 1.0);
+        FragPos = vec3(0.0);
+        Normal = vec3(0.0);
+        Tint = vec3(0.0);
+        return;
+    }
+
+    uint id = uint(gl_InstanceID);
+    vec3 axis = normalize(vec3(rand(id, 0u), rand(id, 1u), rand(id, 2u)) - 0.5 + 1e-3);
+    float angle = mix(0.2, 2.0, rand(id, 3u)) * simDays + 6.2831853 * rand(id, 4u);
+    vec3 shape = vec3(1.0, mix(0.55, 1.0, rand(id, 5u)), mix(0.45, 0.9, rand(id, 6u)));
+    mat3 R = rotation(axis, angle);
+
+    vec3 world = aCenter.xyz + R * (aPos * shape * aOrbit1.w);
+    FragPos = world;
+    Normal = R * normalize(aNormal / shape);
+    Tint = mix(vec3(0.36, 0.33, 0.30), vec3(0.58, 0.52, 0.45), rand(id, 7u));
+    gl_Position = projection * view * vec4(world, 1.0);
+}
@@ -0,0 +1,16 @@
+#version 330 core
+// Resamples an equirectangular image into one cube face (Skybox::buildFromEquirect).
+in vec2 vNdc;
+out vec4 FragColor;
+
+uniform mat3 face;          // columns: s axis, t axis, major axis of the face
+uniform sampler2D equirect;
+
+void main() {
+    vec3 d = normalize(face * vec3(vNdc, 1.0));
+    // sphere.obj mapping, as on the old galaxy sphere: u = longitude from +X
+    // towards +Z; v = latitude, flipped as the loaders negate V (sampled at
+    // -v with GL_REPEAT, i.e. 1 - v)
+    vec2 uv = vec2(fract(atan(d.z, d.x) / 6.2831853), 0.5 - asin(clamp(d.y, -1.0, 1.0)) / 3.1415927);
+    FragColor = vec4(textureLod(equirect, uv, 0.0).rgb, 1.0);
+}
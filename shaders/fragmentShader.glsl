@@ -3,7 +3,9 @@
 in vec2 TexCoord;
 in vec3 FragPos;
 in vec3 Normal;
-in vec4 FragPosLightSpace;
+in float ViewDepth;
+flat in vec4 InstanceTint;
+flat in uvec2 InstanceLayerFlags;   // texture array layer, SphereRenderer flags
 
 out vec4 FragColor;
 
@@ -20,15 +22,65 @@ uniform sampler2D texture1;
 uniform bool useLighting;
 uniform bool useTexture;
 
+// Instanced spheres: the per-instance flags, tint and layer of bodyTextures
+// replace useLighting, useTexture, receiveShadows, objectColor and texture1.
+uniform bool instanced;
+uniform sampler2DArray bodyTextures;
+
+// Streamed planet maps (VirtualTexture.cpp): used instead of texture1 when
+// set. vtIndirection holds one texel per tile of every level (levels stacked
+// by row) pointing at the tile's page in vtAtlas, or at the nearest resident
+// coarser page.
+uniform bool useVirtualTexture;
+uniform sampler2D vtIndirection;
+uniform sampler2D vtAtlas;
+uniform vec4 vtLevels[16];   // per level: width, height, first indirection row
+uniform int vtLevelCount;
+uniform vec4 vtPage;         // tile size, border, page size, atlas size (texels)
+
 // for shadows
-uniform sampler2D shadowMap;
-uniform samplerCube shadowCube2;
+// Light 1: cascaded shadow map (CascadedShadowMap.cpp), one layer per slice
+// of the view depth; cascade i covers view depths up to cascadeSplits[i].
+uniform sampler2DArrayShadow shadowMap;
+uniform mat4 cascadeMatrices[4];
+uniform float cascadeSplits[4];
+uniform int cascadeCount;
+uniform samplerCubeShadow shadowCube2;
 uniform float farPlane2;
+// PCF taps of the shadow tier (ShadowSettings.cpp). Both maps compare in the
+// sampler, so every tap is already a bilinear 2x2 visibility.
+uniform int pcfTaps1;
+uniform int pcfTaps2;
+
+const float PCF_RADIUS1 = 1.5;      // light 1 kernel radius, in texels
+
+// Tap i of n on a Vogel (golden angle) disk of radius 1, turned by phi
+vec2 vogelDisk(int i, int n, float phi)
+{
+    float r = sqrt((float(i) + 0.5) / float(n));
+    float theta = float(i) * 2.39996323 + phi;
+    return r * vec2(cos(theta), sin(theta));
+}
+
+// Per-pixel kernel rotation: neighbouring pixels get unrelated angles, so
+// the few taps blur into fine noise instead of banding
+float interleavedGradientNoise(vec2 pixel)
+{
+    return fract(52.9829189 * fract(dot(pixel, vec2(0.06711056, 0.00583715))));
+}
 
 uniform bool receiveShadows;
 
 float shadowFactor1(vec3 fragPos, vec3 norm) {
-    vec3 proj = FragPosLightSpace.xyz / FragPosLightSpace.w;
+    // nearest cascade that covers the fragment; beyond the last, no shadow
+    int cascade = 0;
+    while (cascade < cascadeCount && ViewDepth > cascadeSplits[cascade])
+        ++cascade;
+    if (cascade == cascadeCount)
+        return 0.0;
+
+    vec4 lightSpace = cascadeMatrices[cascade] * vec4(fragPos, 1.0);
+    vec3 proj = lightSpace.xyz / lightSpace.w;
     proj = proj * 0.5 + 0.5;
 
     if (proj.x < 0.0 || proj.x > 1.0 || proj.y < 0.0 || proj.y > 1.0 || proj.z > 1.0)
@@ -37,14 +89,13 @@ float shadowFactor1(vec3 fragPos, vec3 norm) {
     vec3 L = normalize(lightPos1 - fragPos);
     float bias = max(0.001, 0.005 * (1.0 - dot(norm, L)));
 
-    vec2 texel = 1.0 / vec2(textureSize(shadowMap, 0));
-    float s = 0.0;
-    for (int x=-1; x<=1; ++x)
-        for (int y=-1; y<=1; ++y) {
-            float closest = texture(shadowMap, proj.xy + vec2(x,y) * texel).r;
-            s += (proj.z - bias > closest) ? 1.0 : 0.0;
-        }
-    return s / 9.0;
+    vec2 radius = PCF_RADIUS1 / vec2(textureSize(shadowMap, 0).xy);
+    float phi = 6.2831853 * interleavedGradientNoise(gl_FragCoord.xy);
+    int taps = max(pcfTaps1, 1);
+    float lit = 0.0;
+    for (int i = 0; i < taps; ++i)
+        lit += texture(shadowMap, vec4(proj.xy + vogelDisk(i, taps, phi) * radius, float(cascade), proj.z - bias));
+    return 1.0 - lit / float(taps);
 }
 
 float shadowFactor2(vec3 lightPos, vec3 fragPos, vec3 N)
@@ -58,27 +109,70 @@ float shadowFactor2(vec3 lightPos, vec3 fragPos, vec3 N)
     float ndotl = max(dot(N, normalize(-fragToLight)), 0.0);
     float bias = max(0.002, 0.006 * (1.0 - ndotl));
 
-    // small PCF around the actual vector direction
-    float shadow = 0.0;
-    int samples = 12;
+    // small PCF around the actual vector direction: Vogel disk in the plane
+    // across it
+    vec3 dir = fragToLight / dist;
+    vec3 tangent = normalize(cross(dir, abs(dir.y) < 0.99 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0)));
+    vec3 bitangent = cross(dir, tangent);
     float diskRadius = 0.03 * (dist / farPlane2);
+    float phi = 6.2831853 * interleavedGradientNoise(gl_FragCoord.xy);
+    int taps = max(pcfTaps2, 1);
 
-    for (int i = 0; i < samples; ++i) {
-        // simple quasi-uniform offsets
-        float a = 6.2831853 * (i / float(samples));
-        vec3 offset = vec3(cos(a), sin(a), cos(a * 0.7));
-        float closest = texture(shadowCube2, fragToLight + offset * diskRadius).r;
-        shadow += (current - bias > closest) ? 1.0 : 0.0;
+    float lit = 0.0;
+    for (int i = 0; i < taps; ++i) {
+        vec2 d = vogelDisk(i, taps, phi) * diskRadius;
+        lit += texture(shadowCube2, vec4(fragToLight + tangent * d.x + bitangent * d.y, current - bias));
     }
-    return shadow / float(samples);
+    return 1.0 - lit / float(taps);
+}
+
+vec3 sampleVirtualLevel(vec2 uv, int level)
+{
+    vec4 L = vtLevels[level];
+    ivec2 tile = min(ivec2(uv * L.xy / vtPage.x), ivec2(ceil(L.xy / vtPage.x)) - 1);
+    vec4 entry = texelFetch(vtIndirection, ivec2(tile.x, int(L.z) + tile.y), 0) * 255.0;
+
+    // the entry may point at a coarser page: find that page's tile and
+    // address it there; the border absorbs rounding between levels
+    int resident = int(entry.z + 0.5);
+    vec4 R = vtLevels[resident];
+    ivec2 residentTile = min(tile >> (resident - level), ivec2(ceil(R.xy / vtPage.x)) - 1);
+    vec2 inPage = uv * R.xy - vec2(residentTile) * vtPage.x + vtPage.y;
+    return textureLod(vtAtlas, (floor(entry.xy + 0.5) * vtPage.z + inPage) / vtPage.w, 0.0).rgb;
+}
+
+// Trilinear: the two levels around the screen-space footprint, each bilinear
+// inside its page. TexCoord stays unwrapped for the derivatives.
+vec3 sampleVirtual(vec2 coord)
+{
+    vec2 texel = coord * vtLevels[0].xy;
+    vec2 dx = dFdx(texel), dy = dFdy(texel);
+    float lod = clamp(0.5 * log2(max(dot(dx, dx), dot(dy, dy))), 0.0, float(vtLevelCount - 1));
+    int level = int(lod);
+    int next = min(level + 1, vtLevelCount - 1);
+    vec2 uv = fract(coord);
+    return mix(sampleVirtualLevel(uv, level), sampleVirtualLevel(uv, next), lod - float(level));
 }
 
 void main()
 {
-    vec3 texCol = useTexture ? texture(texture1, TexCoord).rgb : vec3(1.0);
+    bool lit = useLighting, textured = useTexture, shadows = receiveShadows;
+    vec3 tint = objectColor;
+    if (instanced) {
+        uint flags = InstanceLayerFlags.y;
+        lit      = (flags & 1u) != 0u;   // SphereRenderer::LIT
+        textured = (flags & 2u) != 0u;   // TEXTURED
+        shadows  = (flags & 4u) != 0u;   // RECEIVES_SHADOWS
+        tint = InstanceTint.rgb;
+    }
+
+    vec3 texCol = vec3(1.0);
+    if (useVirtualTexture)          texCol = sampleVirtual(TexCoord);
+    else if (instanced && textured) texCol = texture(bodyTextures, vec3(TexCoord, float(InstanceLayerFlags.x))).rgb;
+    else if (textured)              texCol = texture(texture1, TexCoord).rgb;
 
-    if (!useLighting) {
-        vec3 finalColor = useTexture ? texCol : objectColor;
+    if (!lit) {
+        vec3 finalColor = textured ? texCol : tint;
         FragColor = vec4(finalColor, 1.0);
         return;
     }
@@ -102,13 +196,13 @@ void main()
     float spec2 = pow(max(dot(N, H2), 0.0), shininess);
 
     // Shadows
-    float sh1 = receiveShadows ? shadowFactor1(FragPos, N) : 0.0;
-    float sh2 = receiveShadows ? shadowFactor2(lightPos2, FragPos, N) : 0.0;
+    float sh1 = shadows ? shadowFactor1(FragPos, N) : 0.0;
+    float sh2 = shadows ? shadowFactor2(lightPos2, FragPos, N) : 0.0;
 
     vec3 ambient = ambientStrength * (lightColor1 + lightColor2);
     vec3 c1 = (1.0 - sh1) * (1.5 * diff1 * lightColor1 + specularStrength * spec1 * lightColor1);
     vec3 c2 = (1.0 - sh2) * (1.5 * diff2 * lightColor2 + specularStrength * spec2 * lightColor2);
 
-    vec3 lighting = (ambient + c1 + c2) * (objectColor * texCol);
+    vec3 lighting = (ambient + c1 + c2) * (tint * texCol);
     FragColor = vec4(lighting, 1.0);
 }
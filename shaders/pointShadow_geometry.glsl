@@ -0,0 +1,39 @@
+#version 330 core
+// Renders all six faces of the point-light shadow cubemap in one draw: each
+// triangle is projected with every face's matrix and emitted to the layers
+// (gl_Layer = face) it touches.
+layout(triangles) in;
+layout(triangle_strip, max_vertices = 18) out;
+
+uniform mat4 faceVP[6];   // per cube face (proj * view), +X -X +Y -Y +Z -Z
+uniform int faceMask;     // bit per face: faces the object's bounds reach
+
+out vec3 WorldPos;
+
+void main() {
+    for (int face = 0; face < 6; ++face) {
+        if ((faceMask & (1 << face)) == 0) continue;
+
+        vec4 clip[3];
+        for (int i = 0; i < 3; ++i)
+            clip[i] = faceVP[face] * gl_in[i].gl_Position;
+
+        // per-face culling: skip the face if all three corners are outside
+        // the same one of its clip planes
+        bool outside = false;
+        for (int axis = 0; axis < 3; ++axis) {
+            outside = outside ||
+                (clip[0][axis] >  clip[0].w && clip[1][axis] >  clip[1].w && clip[2][axis] >  clip[2].w) ||
+                (clip[0][axis] < -clip[0].w && clip[1][axis] < -clip[1].w && clip[2][axis] < -clip[2].w);
+        }
+        if (outside) continue;
+
+        for (int i = 0; i < 3; ++i) {
+            gl_Layer = face;
+            WorldPos = gl_in[i].gl_Position.xyz;
+            gl_Position = clip[i];
+            EmitVertex();
+        }
+        EndPrimitive();
+    }
+}
@@ -1,13 +1,14 @@
 #version 330 core
 layout(location=0) in vec3 aPos;
+layout(location=14) in vec4 aPosScale;   // see vertexShader.glsl
+layout(location=15) in vec3 aPosOffset;
+layout(location=3) in mat4 aInstanceModel;    // SphereRenderer instances
 
 uniform mat4 model;
-uniform mat4 vp;      // per-cube-face (proj * view)
-
-out vec3 WorldPos;
+uniform bool instanced;
 
+// World space; pointShadow_geometry.glsl projects it once per cube face.
 void main() {
-    vec4 wp = model * vec4(aPos, 1.0);
-    WorldPos = wp.xyz;
-    gl_Position = vp * wp;
+    vec3 pos = (aPosScale.w == 0.0) ? aPosOffset + aPos * aPosScale.xyz : aPos;
+    gl_Position = (instanced ? aInstanceModel : model) * vec4(pos, 1.0);
 }
@@ -1,9 +1,14 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
+layout (location = 14) in vec4 aPosScale;   // see vertexShader.glsl
+layout (location = 15) in vec3 aPosOffset;
+layout (location = 3) in mat4 aInstanceModel;   // SphereRenderer instances
 
 uniform mat4 lightSpaceMatrix;
 uniform mat4 model;
+uniform bool instanced;
 
 void main() {
-    gl_Position = lightSpaceMatrix * model * vec4(aPos, 1.0);
+    vec3 pos = (aPosScale.w == 0.0) ? aPosOffset + aPos * aPosScale.xyz : aPos;
+    gl_Position = lightSpaceMatrix * (instanced ? aInstanceModel : model) * vec4(pos, 1.0);
 }
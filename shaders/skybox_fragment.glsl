@@ -0,0 +1,11 @@
+#version 330 core
+in vec2 vNdc;
+out vec4 FragColor;
+
+uniform mat4 invViewProj;   // inverse(projection * view without translation)
+uniform samplerCube skybox;
+
+void main() {
+    vec4 dir = invViewProj * vec4(vNdc, 1.0, 1.0);
+    FragColor = vec4(texture(skybox, dir.xyz / dir.w).rgb, 1.0);
+}
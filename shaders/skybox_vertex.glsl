@@ -0,0 +1,9 @@
+#version 330 core
+// Full-screen triangle from gl_VertexID (no vertex buffer), at depth = far.
+out vec2 vNdc;
+
+void main() {
+    vec2 p = vec2(gl_VertexID == 1 ? 3.0 : -1.0, gl_VertexID == 2 ? 3.0 : -1.0);
+    vNdc = p;
+    gl_Position = vec4(p, 1.0, 1.0);
+}
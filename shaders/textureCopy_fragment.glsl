@@ -0,0 +1,12 @@
+#version 330 core
+// Resamples a 2D texture into a texture array layer (SphereRenderer::setLayer),
+// drawn as a full-screen triangle with skybox_vertex.glsl. The implicit LOD
+// picks the source mip that matches the layer size.
+in vec2 vNdc;
+out vec4 FragColor;
+
+uniform sampler2D source;
+
+void main() {
+    FragColor = vec4(texture(source, vNdc * 0.5 + 0.5).rgb, 1.0);
+}
@@ -1,24 +1,53 @@
 #version 330 core
 layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec2 aTexCoord;
-layout(location = 2) in vec3 aNormal;
+layout(location = 2) in vec3 aNormal;   // packed meshes: octahedral xy, z unused
+
+// Per-mesh dequantisation set by MeshHandle::draw() as generic attributes.
+// Float VAOs leave them at the GL default (0,0,0,1), so w != 0 means "not packed".
+layout(location = 14) in vec4 aPosScale;
+layout(location = 15) in vec3 aPosOffset;
+
+// Instanced spheres (SphereRenderer): model, tint, texture layer and flags
+// per instance instead of uniforms.
+layout(location = 3) in mat4 aInstanceModel;   // 3..6
+layout(location = 7) in vec4 aInstanceTint;
+layout(location = 8) in uvec2 aInstanceLayerFlags;
 
 out vec2 TexCoord;
 out vec3 Normal;
 out vec3 FragPos;
-out vec4 FragPosLightSpace;
+out float ViewDepth;         // cascade selection (CascadedShadowMap)
+flat out vec4 InstanceTint;
+flat out uvec2 InstanceLayerFlags;
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
-uniform mat4 lightSpaceMatrix;
+uniform bool instanced;
+
+vec3 octDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
 
 void main()
 {
-    vec4 world = model * vec4(aPos, 1.0);
+    bool packedMesh = aPosScale.w == 0.0;
+    vec3 pos = packedMesh ? aPosOffset + aPos * aPosScale.xyz : aPos;
+    vec3 nrm = packedMesh ? octDecode(aNormal.xy) : aNormal;
+
+    mat4 M = instanced ? aInstanceModel : model;
+    InstanceTint = instanced ? aInstanceTint : vec4(1.0);
+    InstanceLayerFlags = instanced ? aInstanceLayerFlags : uvec2(0u);
+
+    vec4 world = M * vec4(pos, 1.0);
     FragPos = world.xyz;
-    Normal = mat3(transpose(inverse(model))) * aNormal;
+    Normal = mat3(transpose(inverse(M))) * nrm;
     TexCoord = aTexCoord;
-    FragPosLightSpace = lightSpaceMatrix * world;
+    ViewDepth = -(view * world).z;
     gl_Position = projection * view * world;
 }
@@ -0,0 +1,239 @@
+#include "AsteroidBelt.h"
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+// ------- rock mesh: a displaced icosphere, one subdivision level per LOD -------
+namespace {
+    struct RockVertex {
+        glm::vec3 position;
+        glm::vec3 normal;
+    };
+
+    // Icosahedron subdivided 'levels' times onto the unit sphere, CCW outwards.
+    void icosphere(int levels, std::vector<glm::vec3>& points, std::vector<unsigned int>& indices) {
+        const float t = (1.0f + std::sqrt(5.0f)) * 0.5f;
+        points = { {-1, t, 0}, { 1, t, 0}, {-1,-t, 0}, { 1,-t, 0},
+                   { 0,-1, t}, { 0, 1, t}, { 0,-1,-t}, { 0, 1,-t},
+                   { t, 0,-1}, { t, 0, 1}, {-t, 0,-1}, {-t, 0, 1} };
+        for (glm::vec3& p : points) p = glm::normalize(p);
+        indices = { 0,11,5, 0,5,1, 0,1,7, 0,7,10, 0,10,11, 1,5,9, 5,11,4, 11,10,2, 10,7,6, 7,1,8,
+                    3,9,4, 3,4,2, 3,2,6, 3,6,8, 3,8,9, 4,9,5, 2,4,11, 6,2,10, 8,6,7, 9,8,1 };
+        for (int l = 0; l < levels; ++l) {
+            std::map<std::pair<unsigned int, unsigned int>, unsigned int> midpoints;
+            auto midpoint = [&](unsigned int a, unsigned int b) {
+                std::pair<unsigned int, unsigned int> key(std::min(a, b), std::max(a, b));
+                auto found = midpoints.find(key);
+                if (found != midpoints.end()) return found->second;
+                points.push_back(glm::normalize(points[a] + points[b]));
+                unsigned int i = (unsigned int)points.size() - 1;
+                midpoints.emplace(key, i);
+                return i;
+            };
+            std::vector<unsigned int> next;
+            next.reserve(indices.size() * 4);
+            for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+                unsigned int a = indices[i], b = indices[i + 1], c = indices[i + 2];
+                unsigned int ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+                next.insert(next.end(), { a, ab, ca,  b, bc, ab,  c, ca, bc,  ab, bc, ca });
+            }
+            indices.swap(next);
+        }
+    }
+
+    // Radius of the rock along unit direction n: a few smooth lobes and dents.
+    // Coarser LODs sample the same function at a subset of the directions.
+    float rockRadius(const glm::vec3& n, const std::vector<glm::vec4>& bumps) {
+        float r = 1.0f;
+        for (const glm::vec4& b : bumps) {
+            float d = std::max(glm::dot(n, glm::vec3(b)), 0.0f);
+            r += b.w * d * d * d * d;
+        }
+        return r;
+    }
+}
+
+void AsteroidBelt::createMesh() {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<glm::vec4> bumps(8);
+    for (glm::vec4& b : bumps) {
+        float z = unit(rng) * 2.0f - 1.0f, phi = unit(rng) * glm::two_pi<float>();
+        float s = std::sqrt(1.0f - z * z);
+        b = glm::vec4(s * std::cos(phi), s * std::sin(phi), z, (unit(rng) - 0.4f) * 0.5f);
+    }
+
+    // LOD0 = 2 subdivisions (320 triangles), LOD1 = 1 (80), LOD2 = the icosahedron (20)
+    std::vector<RockVertex> vertices;
+    std::vector<unsigned int> indices;
+    float maxRadius = 0.0f;
+    for (int lod = 0; lod < LOD_COUNT; ++lod) {
+        std::vector<glm::vec3> points;
+        std::vector<unsigned int> tris;
+        icosphere(LOD_COUNT - 1 - lod, points, tris);
+
+        size_t first = vertices.size();
+        for (const glm::vec3& p : points) {
+            float r = rockRadius(p, bumps);
+            maxRadius = std::max(maxRadius, r);
+            vertices.push_back({ p * r, glm::vec3(0.0f) });
+        }
+        for (size_t i = 0; i + 2 < tris.size(); i += 3) {
+            RockVertex& a = vertices[first + tris[i]];
+            RockVertex& b = vertices[first + tris[i + 1]];
+            RockVertex& c = vertices[first + tris[i + 2]];
+            glm::vec3 n = glm::cross(b.position - a.position, c.position - a.position);   // area weighted
+            a.normal += n; b.normal += n; c.normal += n;
+        }
+        for (size_t i = first; i < vertices.size(); ++i)
+            vertices[i].normal = glm::normalize(vertices[i].normal);
+
+        lods[lod].firstIndex = (GLuint)indices.size();
+        lods[lod].indexCount = (GLsizei)tris.size();
+        lods[lod].baseVertex = (GLint)first;
+        indices.insert(indices.end(), tris.begin(), tris.end());
+    }
+    // unit bounding radius, so an asteroid's size is its culling radius
+    for (RockVertex& v : vertices) v.position /= maxRadius;
+
+    glGenBuffers(1, &meshVBO);
+    glGenBuffers(1, &meshEBO);
+    glBindBuffer(GL_ARRAY_BUFFER, meshVBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(RockVertex), vertices.data(), GL_STATIC_DRAW);
+    glBindVertexArray(drawVAO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, meshEBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(RockVertex), (void*)offsetof(RockVertex, position));
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(RockVertex), (void*)offsetof(RockVertex, normal));
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void AsteroidBelt::init(GLuint orbitProg, GLuint drawProg, size_t count, uint32_t seed) {
+    release();
+    orbitProgram = orbitProg;
+    drawProgram = drawProg;
+    asteroids = count;
+    uOrbitSimDays       = glGetUniformLocation(orbitProgram, "simDays");
+    uOrbitView          = glGetUniformLocation(orbitProgram, "view");
+    uOrbitProjection    = glGetUniformLocation(orbitProgram, "projection");
+    uOrbitCameraPos     = glGetUniformLocation(orbitProgram, "cameraPos");
+    uOrbitPixelsPerUnit = glGetUniformLocation(orbitProgram, "pixelsPerUnit");
+    uOrbitLodPixels     = glGetUniformLocation(orbitProgram, "lodPixels");
+    uDrawSimDays        = glGetUniformLocation(drawProgram, "simDays");
+    uDrawView           = glGetUniformLocation(drawProgram, "view");
+    uDrawProjection     = glGetUniformLocation(drawProgram, "projection");
+    uDrawLod            = glGetUniformLocation(drawProgram, "lod");
+
+    glGenVertexArrays(1, &orbitVAO);
+    glGenVertexArrays(1, &drawVAO);
+    createMesh();
+    if (!asteroids) return;
+
+    // Orbital elements, two vec4 per asteroid (asteroidOrbit_vertex.glsl):
+    // semi-major axis, eccentricity, inclination, ascending node;
+    // argument of periapsis, mean anomaly at day 0, mean motion, radius.
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const float twoPi = glm::two_pi<float>();
+    std::vector<glm::vec4> elements(asteroids * 2);
+    for (size_t i = 0; i < asteroids; ++i) {
+        float a = innerRadius + (outerRadius - innerRadius) * 0.5f * (unit(rng) + unit(rng));   // densest mid-belt
+        float e = maxEccentricity * unit(rng) * unit(rng);
+        float inclination = maxInclination * unit(rng);
+        float period = referencePeriod * std::pow(a / referenceRadius, 1.5f);
+        float size = minSize * std::pow(maxSize / minSize, unit(rng) * unit(rng) * unit(rng));
+        elements[i * 2 + 0] = glm::vec4(a, e, inclination, twoPi * unit(rng));
+        elements[i * 2 + 1] = glm::vec4(twoPi * unit(rng), twoPi * unit(rng), twoPi / period, size);
+    }
+
+    glGenBuffers(1, &orbitVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, orbitVBO);
+    glBufferData(GL_ARRAY_BUFFER, elements.size() * sizeof(glm::vec4), elements.data(), GL_STATIC_DRAW);
+    glGenBuffers(1, &centerVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, centerVBO);
+    glBufferData(GL_ARRAY_BUFFER, asteroids * sizeof(glm::vec4), nullptr, GL_DYNAMIC_COPY);
+
+    // orbit pass: the elements per vertex, one point per asteroid
+    const GLsizei stride = 2 * sizeof(glm::vec4);
+    glBindVertexArray(orbitVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, orbitVBO);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, stride, (void*)0);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, (void*)sizeof(glm::vec4));
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+
+    // draw pass: the rock mesh plus, per instance, this frame's centre and the radius
+    glBindVertexArray(drawVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, centerVBO);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)0);
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
+    glBindBuffer(GL_ARRAY_BUFFER, orbitVBO);
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, stride, (void*)sizeof(glm::vec4));
+    glEnableVertexAttribArray(3);
+    glVertexAttribDivisor(3, 1);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    std::cout << "Asteroid belt: " << asteroids << " asteroids, "
+              << asteroids * 3 * sizeof(glm::vec4) / 1024 << " KB of instance data" << std::endl;
+}
+
+void AsteroidBelt::update(float simDays, const glm::mat4& view, const glm::mat4& projection, const LodView& lodView) {
+    if (!asteroids) return;
+    glUseProgram(orbitProgram);
+    glUniform1f(uOrbitSimDays, simDays);
+    glUniformMatrix4fv(uOrbitView, 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(uOrbitProjection, 1, GL_FALSE, glm::value_ptr(projection));
+    glUniform3fv(uOrbitCameraPos, 1, glm::value_ptr(lodView.cameraPos));
+    glUniform1f(uOrbitPixelsPerUnit, lodView.pixelsPerUnit);
+    glUniform3f(uOrbitLodPixels, lod0Pixels, lod1Pixels, cullPixels);
+
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBindVertexArray(orbitVAO);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, centerVBO);
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, (GLsizei)asteroids);
+    glEndTransformFeedback();
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glBindVertexArray(0);
+    glDisable(GL_RASTERIZER_DISCARD);
+}
+
+void AsteroidBelt::draw(float simDays, const glm::mat4& view, const glm::mat4& projection) const {
+    if (!asteroids) return;
+    glUseProgram(drawProgram);
+    glUniform1f(uDrawSimDays, simDays);
+    glUniformMatrix4fv(uDrawView, 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(uDrawProjection, 1, GL_FALSE, glm::value_ptr(projection));
+    glBindVertexArray(drawVAO);
+    for (int lod = 0; lod < LOD_COUNT; ++lod) {
+        const Lod& l = lods[lod];
+        glUniform1i(uDrawLod, lod);
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, l.indexCount, GL_UNSIGNED_INT,
+                                          (void*)(sizeof(unsigned int) * (size_t)l.firstIndex),
+                                          (GLsizei)asteroids, l.baseVertex);
+    }
+    glBindVertexArray(0);
+}
+
+void AsteroidBelt::release() {
+    if (centerVBO) glDeleteBuffers(1, &centerVBO);
+    if (orbitVBO) glDeleteBuffers(1, &orbitVBO);
+    if (meshEBO) glDeleteBuffers(1, &meshEBO);
+    if (meshVBO) glDeleteBuffers(1, &meshVBO);
+    if (drawVAO) glDeleteVertexArrays(1, &drawVAO);
+    if (orbitVAO) glDeleteVertexArrays(1, &orbitVAO);
+    centerVBO = orbitVBO = meshEBO = meshVBO = drawVAO = orbitVAO = 0;
+    asteroids = 0;
+}
@@ -0,0 +1,70 @@
+// AsteroidBelt.h
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include "MeshCache.h"
+
+// A belt of up to millions of asteroids at a CPU cost per frame that does not
+// depend on their number. Orbital elements are generated once into a GPU
+// buffer; each frame an orbit pass (one point per asteroid, rasterizer
+// discarded) solves Kepler's equation at simDays, frustum-culls the result
+// and picks a LOD band, capturing position and band with transform feedback.
+// The rock mesh is then drawn with one instanced draw per LOD over all
+// asteroids, and the vertex shader collapses instances that belong to
+// another band. Asteroids neither cast nor receive shadows.
+class AsteroidBelt {
+public:
+    // Belt shape, in world units; set before init().
+    float innerRadius = 3.4f, outerRadius = 4.6f;
+    float minSize = 0.006f, maxSize = 0.03f;    // asteroid radius; small ones dominate
+    float maxEccentricity = 0.08f;
+    float maxInclination = 0.06f;               // radians
+    // Kepler's third law from one reference orbit:
+    // period = referencePeriod * (a / referenceRadius)^1.5, in sim days.
+    float referenceRadius = 5.0f, referencePeriod = 365.0f;
+
+    // LOD bands by projected radius in pixels: LOD0 at or above lod0Pixels,
+    // LOD1 at or above lod1Pixels, LOD2 below; asteroids under cullPixels
+    // are skipped.
+    float lod0Pixels = 12.0f, lod1Pixels = 3.0f, cullPixels = 0.3f;
+
+    // orbitProgram: shaders/asteroidOrbit_vertex.glsl alone, linked with
+    // "Center" as its transform feedback varying. drawProgram:
+    // asteroid_vertex.glsl with asteroid_fragment.glsl; its light uniforms
+    // are the caller's. Generates the belt on the CPU once (O(count)).
+    void init(GLuint orbitProgram, GLuint drawProgram, size_t count, uint32_t seed = 1);
+    size_t count() const { return asteroids; }
+
+    // Orbit pass. Call once per frame before draw(), with the camera's matrices.
+    void update(float simDays, const glm::mat4& view, const glm::mat4& projection, const LodView& lodView);
+
+    // Colour pass: one instanced draw per LOD. Leaves drawProgram current.
+    void draw(float simDays, const glm::mat4& view, const glm::mat4& projection) const;
+
+    void release();
+
+private:
+    static const int LOD_COUNT = 3;
+    struct Lod {
+        GLuint  firstIndex;
+        GLsizei indexCount;
+        GLint   baseVertex;
+    };
+
+    void createMesh();
+
+    GLuint orbitProgram = 0, drawProgram = 0;
+    GLuint orbitVAO = 0, drawVAO = 0;
+    GLuint orbitVBO = 0;        // per asteroid: two vec4 of orbital elements, static
+    GLuint centerVBO = 0;       // per asteroid: vec4 from the orbit pass
+    GLuint meshVBO = 0, meshEBO = 0;
+    Lod lods[LOD_COUNT] = {};
+    size_t asteroids = 0;
+
+    GLint uOrbitSimDays = -1, uOrbitView = -1, uOrbitProjection = -1;
+    GLint uOrbitCameraPos = -1, uOrbitPixelsPerUnit = -1, uOrbitLodPixels = -1;
+    GLint uDrawSimDays = -1, uDrawView = -1, uDrawProjection = -1, uDrawLod = -1;
+};
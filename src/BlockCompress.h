@@ -0,0 +1,211 @@
+// BlockCompress.h
+// BC1 (DXT1) / BC3 (DXT5) block encoders and box-filtered mip generation,
+// used offline by tools/textureBake.cpp. 8-bit RGBA input, rows top to bottom.
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace bc {
+    inline uint16_t to565(const float c[3]) {
+        int r = (int)std::lround(std::min(std::max(c[0], 0.0f), 255.0f) * 31.0f / 255.0f);
+        int g = (int)std::lround(std::min(std::max(c[1], 0.0f), 255.0f) * 63.0f / 255.0f);
+        int b = (int)std::lround(std::min(std::max(c[2], 0.0f), 255.0f) * 31.0f / 255.0f);
+        return (uint16_t)((r << 11) | (g << 5) | b);
+    }
+
+    inline void from565(uint16_t v, float out[3]) {
+        int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+        out[0] = (float)((r << 3) | (r >> 2));
+        out[1] = (float)((g << 2) | (g >> 4));
+        out[2] = (float)((b << 3) | (b >> 2));
+    }
+
+    inline float dist2(const float a[3], const float b[3]) {
+        float dr = a[0] - b[0], dg = a[1] - b[1], db = a[2] - b[2];
+        return dr * dr + dg * dg + db * db;
+    }
+
+    // Four-colour palette from 565 endpoints (c0 > c1 selects 4-colour mode).
+    inline void palette(uint16_t c0, uint16_t c1, float pal[4][3]) {
+        from565(c0, pal[0]);
+        from565(c1, pal[1]);
+        for (int k = 0; k < 3; ++k) {
+            pal[2][k] = (2.0f * pal[0][k] + pal[1][k]) / 3.0f;
+            pal[3][k] = (pal[0][k] + 2.0f * pal[1][k]) / 3.0f;
+        }
+    }
+
+    inline uint32_t pickIndices(const float px[16][3], const float pal[4][3], float* error) {
+        uint32_t bits = 0;
+        float total = 0.0f;
+        for (int i = 0; i < 16; ++i) {
+            int best = 0;
+            float bestD = dist2(px[i], pal[0]);
+            for (int j = 1; j < 4; ++j) {
+                float d = dist2(px[i], pal[j]);
+                if (d < bestD) { bestD = d; best = j; }
+            }
+            bits |= (uint32_t)best << (2 * i);
+            total += bestD;
+        }
+        if (error) *error = total;
+        return bits;
+    }
+}
+
+// Encodes one 4x4 block (RGBA8, 16 pixels row-major) to 8 bytes of BC1 colour.
+// Endpoints come from the principal axis, then one least-squares refinement.
+inline void encodeBC1Block(const uint8_t rgba[64], uint8_t out[8]) {
+    using namespace bc;
+    float px[16][3];
+    float mean[3] = { 0, 0, 0 };
+    for (int i = 0; i < 16; ++i)
+        for (int k = 0; k < 3; ++k) { px[i][k] = rgba[i * 4 + k]; mean[k] += px[i][k] / 16.0f; }
+
+    float cov[6] = { 0, 0, 0, 0, 0, 0 };
+    for (int i = 0; i < 16; ++i) {
+        float d[3] = { px[i][0] - mean[0], px[i][1] - mean[1], px[i][2] - mean[2] };
+        cov[0] += d[0] * d[0]; cov[1] += d[0] * d[1]; cov[2] += d[0] * d[2];
+        cov[3] += d[1] * d[1]; cov[4] += d[1] * d[2]; cov[5] += d[2] * d[2];
+    }
+    float axis[3] = { 1, 1, 1 };
+    for (int it = 0; it < 8; ++it) { // power iteration
+        float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+        float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+        float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+        float len = std::sqrt(x * x + y * y + z * z);
+        if (len < 1e-6f) break;
+        axis[0] = x / len; axis[1] = y / len; axis[2] = z / len;
+    }
+
+    float lo = 1e30f, hi = -1e30f;
+    for (int i = 0; i < 16; ++i) {
+        float t = (px[i][0] - mean[0]) * axis[0] + (px[i][1] - mean[1]) * axis[1] + (px[i][2] - mean[2]) * axis[2];
+        lo = std::min(lo, t);
+        hi = std::max(hi, t);
+    }
+    float e0[3], e1[3];
+    for (int k = 0; k < 3; ++k) { e0[k] = mean[k] + axis[k] * hi; e1[k] = mean[k] + axis[k] * lo; }
+
+    uint16_t c0 = to565(e0), c1 = to565(e1);
+    float pal[4][3], err = 0.0f;
+    if (c0 < c1) std::swap(c0, c1);
+    palette(c0, c1, pal);
+    uint32_t bits = pickIndices(px, pal, &err);
+
+    // least-squares endpoints for the chosen indices
+    if (c0 != c1) {
+        const float w[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+        float aa = 0, bb = 0, ab = 0, ax[3] = { 0, 0, 0 }, bx[3] = { 0, 0, 0 };
+        for (int i = 0; i < 16; ++i) {
+            float a = w[(bits >> (2 * i)) & 3], b = 1.0f - a;
+            aa += a * a; bb += b * b; ab += a * b;
+            for (int k = 0; k < 3; ++k) { ax[k] += a * px[i][k]; bx[k] += b * px[i][k]; }
+        }
+        float det = aa * bb - ab * ab;
+        if (std::fabs(det) > 1e-6f) {
+            float n0[3], n1[3];
+            for (int k = 0; k < 3; ++k) {
+                n0[k] = (ax[k] * bb - bx[k] * ab) / det;
+                n1[k] = (bx[k] * aa - ax[k] * ab) / det;
+            }
+            uint16_t d0 = to565(n0), d1 = to565(n1);
+            if (d0 < d1) std::swap(d0, d1);
+            if (d0 != d1) {
+                float pal2[4][3], err2 = 0.0f;
+                palette(d0, d1, pal2);
+                uint32_t bits2 = pickIndices(px, pal2, &err2);
+                if (err2 < err) { c0 = d0; c1 = d1; bits = bits2; }
+            }
+        }
+    }
+    if (c0 == c1) bits = 0; // 3-colour mode would kick in; all pixels use c0
+
+    out[0] = (uint8_t)(c0 & 0xFF); out[1] = (uint8_t)(c0 >> 8);
+    out[2] = (uint8_t)(c1 & 0xFF); out[3] = (uint8_t)(c1 >> 8);
+    memcpy(out + 4, &bits, 4); // little endian, like the format
+}
+
+// BC3 = 8-byte interpolated alpha block + BC1 colour block.
+inline void encodeBC3Block(const uint8_t rgba[64], uint8_t out[16]) {
+    uint8_t a0 = 0, a1 = 255;
+    for (int i = 0; i < 16; ++i) {
+        a0 = std::max(a0, rgba[i * 4 + 3]);
+        a1 = std::min(a1, rgba[i * 4 + 3]);
+    }
+    out[0] = a0;
+    out[1] = a1;
+    uint64_t bits = 0;
+    if (a0 > a1) { // 8-value mode
+        float pal[8];
+        pal[0] = a0; pal[1] = a1;
+        for (int j = 1; j < 7; ++j) pal[j + 1] = ((7 - j) * a0 + j * a1) / 7.0f;
+        for (int i = 0; i < 16; ++i) {
+            int best = 0;
+            float bestD = 1e30f;
+            for (int j = 0; j < 8; ++j) {
+                float d = std::fabs(pal[j] - rgba[i * 4 + 3]);
+                if (d < bestD) { bestD = d; best = j; }
+            }
+            bits |= (uint64_t)best << (3 * i);
+        }
+    }
+    for (int k = 0; k < 6; ++k) out[2 + k] = (uint8_t)(bits >> (8 * k));
+    encodeBC1Block(rgba, out + 8);
+}
+
+// Compresses a whole level. Edge blocks repeat the last row/column.
+inline std::vector<uint8_t> compressLevel(const uint8_t* rgba, int width, int height, bool withAlpha) {
+    int bw = (width + 3) / 4, bh = (height + 3) / 4;
+    size_t blockBytes = withAlpha ? 16 : 8;
+    std::vector<uint8_t> out((size_t)bw * bh * blockBytes);
+    uint8_t block[64];
+    for (int by = 0; by < bh; ++by) {
+        for (int bx = 0; bx < bw; ++bx) {
+            for (int y = 0; y < 4; ++y) {
+                int sy = std::min(by * 4 + y, height - 1);
+                for (int x = 0; x < 4; ++x) {
+                    int sx = std::min(bx * 4 + x, width - 1);
+                    memcpy(block + (y * 4 + x) * 4, rgba + ((size_t)sy * width + sx) * 4, 4);
+                }
+            }
+            uint8_t* dst = out.data() + ((size_t)by * bw + bx) * blockBytes;
+            if (withAlpha) encodeBC3Block(block, dst);
+            else encodeBC1Block(block, dst);
+        }
+    }
+    return out;
+}
+
+// 2x2 box filter (matches what glGenerateMipmap does on most drivers). For
+// odd sizes the last output row/column averages 3 source texels, so the
+// extra row/column is folded in instead of dropped.
+inline std::vector<uint8_t> downsampleRGBA(const std::vector<uint8_t>& src, int width, int height,
+                                           int& outWidth, int& outHeight) {
+    outWidth = std::max(1, width / 2);
+    outHeight = std::max(1, height / 2);
+    // source texels behind output texel i along one axis
+    auto span = [](int i, int outSize, int size) {
+        return size == 1 ? 1 : (i == outSize - 1 && size % 2 ? 3 : 2);
+    };
+    std::vector<uint8_t> dst((size_t)outWidth * outHeight * 4);
+    for (int y = 0; y < outHeight; ++y) {
+        int ny = span(y, outHeight, height);
+        for (int x = 0; x < outWidth; ++x) {
+            int nx = span(x, outWidth, width), n = nx * ny;
+            const uint8_t* corner = src.data() + ((size_t)y * 2 * width + x * 2) * 4;
+            for (int k = 0; k < 4; ++k) {
+                int s = 0;
+                for (int dy = 0; dy < ny; ++dy)
+                    for (int dx = 0; dx < nx; ++dx)
+                        s += corner[((size_t)dy * width + dx) * 4 + k];
+                dst[((size_t)y * outWidth + x) * 4 + k] = (uint8_t)((s + n / 2) / n);
+            }
+        }
+    }
+    return dst;
+}
@@ -0,0 +1,109 @@
+#include "CascadedShadowMap.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cmath>
+
+void CascadedShadowMap::init(int size, GLenum depthFormat) {
+    release();
+    mapSize = size;
+
+    glGenTextures(1, &depthArray);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, depthArray);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, (GLint)depthFormat, mapSize, mapSize, MAX_CASCADES, 0,
+                 GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    // sampled as sampler2DArrayShadow: the compare is done per texel and filtered
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    const float borderCol[4] = { 1, 1, 1, 1 };
+    glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, borderCol);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    GLint previousFBO = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFBO);
+    glGenFramebuffers(MAX_CASCADES, fbos);
+    for (int c = 0; c < MAX_CASCADES; ++c) {
+        glBindFramebuffer(GL_FRAMEBUFFER, fbos[c]);
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthArray, 0, c);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        caches[c].init(fbos[c], mapSize, mapSize, depthFormat);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)previousFBO);
+}
+
+void CascadedShadowMap::fit(const glm::mat4& view, float fovyRadians, float aspect, float nearPlane,
+                            const glm::vec3& lightDir, unsigned refitMask) {
+    const int count = std::min(std::max(cascadeCount, 1), MAX_CASCADES);
+    const glm::mat4 cameraToWorld = glm::inverse(view);
+    const glm::vec3 dir = glm::normalize(lightDir);
+    const glm::vec3 up = (std::fabs(dir.y) > 0.99f) ? glm::vec3(0, 0, 1) : glm::vec3(0, 1, 0);
+    const glm::mat4 lightRotation = glm::lookAt(glm::vec3(0.0f), dir, up);
+
+    // squared slope of the frustum's corner rays off the view axis
+    const float tanY = std::tan(0.5f * fovyRadians), tanX = tanY * aspect;
+    const float k2 = tanX * tanX + tanY * tanY;
+    const float farPlane = std::max(shadowDistance, nearPlane * 2.0f);
+
+    float sliceNear = nearPlane;
+    for (int c = 0; c < count; ++c) {
+        float t = (float)(c + 1) / count;
+        float logSplit = nearPlane * std::pow(farPlane / nearPlane, t);
+        float uniformSplit = nearPlane + (farPlane - nearPlane) * t;
+        float sliceFar = splitLambda * logSplit + (1.0f - splitLambda) * uniformSplit;
+
+        // Smallest sphere through the slice's corners: its center sits on
+        // the view axis at the depth equidistant from near and far corners,
+        // or at the far plane when that lies beyond it.
+        float z = 0.5f * (sliceFar + sliceNear) * (1.0f + k2);
+        float radius;
+        if (z >= sliceFar) {
+            z = sliceFar;
+            radius = sliceFar * std::sqrt(k2);
+        } else {
+            radius = std::sqrt((sliceFar - z) * (sliceFar - z) + k2 * sliceFar * sliceFar);
+        }
+        radius = std::ceil(radius * 16.0f) / 16.0f;     // keep tiny float changes from rescaling
+        splits[c] = sliceFar;
+        sliceNear = sliceFar;
+        if (!(refitMask & (1u << c)))
+            continue;
+
+        // snap the center to the texel grid of the light's view
+        glm::vec3 center = glm::vec3(cameraToWorld * glm::vec4(0.0f, 0.0f, -z, 1.0f));
+        glm::vec3 lc = glm::vec3(lightRotation * glm::vec4(center, 1.0f));
+        float texel = 2.0f * radius / (float)std::max(mapSize, 1);
+        lc.x = std::floor(lc.x / texel) * texel;
+        lc.y = std::floor(lc.y / texel) * texel;
+
+        glm::mat4 projection = glm::ortho(lc.x - radius, lc.x + radius, lc.y - radius, lc.y + radius,
+                                          -lc.z - radius - casterDistance, -lc.z + radius);
+        matrices[c] = projection * lightRotation;
+    }
+    cascadeCount = count;
+}
+
+void CascadedShadowMap::setUniforms(GLuint program) const {
+    if (program != uniformProgram) {
+        uniformProgram = program;
+        uniforms.matrices = glGetUniformLocation(program, "cascadeMatrices");
+        uniforms.splits = glGetUniformLocation(program, "cascadeSplits");
+        uniforms.count = glGetUniformLocation(program, "cascadeCount");
+    }
+    glUniformMatrix4fv(uniforms.matrices, MAX_CASCADES, GL_FALSE, glm::value_ptr(matrices[0]));
+    glUniform1fv(uniforms.splits, MAX_CASCADES, splits);
+    glUniform1i(uniforms.count, cascadeCount);
+}
+
+void CascadedShadowMap::release() {
+    for (ShadowCache& cache : caches)
+        cache.release();
+    if (fbos[0]) glDeleteFramebuffers(MAX_CASCADES, fbos);
+    if (depthArray) glDeleteTextures(1, &depthArray);
+    for (GLuint& fbo : fbos) fbo = 0;
+    depthArray = 0;
+}
@@ -0,0 +1,71 @@
+// CascadedShadowMap.h
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "ShadowCache.h"
+
+// Directional-light shadow split into cascades along the camera's view
+// depth, stored as the layers of one depth texture array
+// (fragmentShader.glsl: shadowMap, cascadeMatrices, cascadeSplits). Each
+// cascade covers the bounding sphere of its slice of the view frustum, so
+// near cascades spend their texels on a few world units and texel density
+// follows viewing distance instead of the scene's extent. Splits blend
+// logarithmic and uniform spacing.
+//
+// Against shimmering the sphere's radius depends only on the split
+// distances and the field of view, and its center is snapped to whole
+// texels in light space: moving or turning the camera shifts the map in
+// texel steps and never rescales it.
+class CascadedShadowMap {
+public:
+    static const int MAX_CASCADES = 4;
+
+    int   cascadeCount = 4;         // 1..MAX_CASCADES
+    float splitLambda = 0.75f;      // 0 = uniform splits, 1 = logarithmic
+    float shadowDistance = 40.0f;   // view depth covered; further away is unshadowed
+    float casterDistance = 30.0f;   // casters this far towards the light from a slice still cast into it
+
+    // Layers of size x size. Call again to change resolution or format; the
+    // caches start over.
+    void init(int size, GLenum depthFormat = GL_DEPTH_COMPONENT24);
+
+    // Fits the cascades in refitMask (bit per cascade) to the camera; the
+    // others keep their matrix, to go with their map while it is not
+    // re-rendered. No GL calls. lightDir points from the light into the scene.
+    void fit(const glm::mat4& view, float fovyRadians, float aspect, float nearPlane, const glm::vec3& lightDir,
+             unsigned refitMask = ~0u);
+
+    // Light view-projection of cascade c, from the last fit().
+    const glm::mat4& matrix(int c) const { return matrices[c]; }
+    // Far view depth of cascade c.
+    float splitFar(int c) const { return splits[c]; }
+
+    int size() const { return mapSize; }
+    GLuint texture() const { return depthArray; }
+    // The cascade's layer as a depth-only framebuffer, and its cache.
+    GLuint framebuffer(int c) const { return fbos[c]; }
+    ShadowCache& cache(int c) { return caches[c]; }
+    const ShadowCache& cache(int c) const { return caches[c]; }
+
+    // cascadeMatrices, cascadeSplits and cascadeCount of a fragmentShader.glsl
+    // program, which must be current. Locations are looked up again only
+    // when the program changes.
+    void setUniforms(GLuint program) const;
+
+    void release();
+
+private:
+    GLuint depthArray = 0;
+    GLuint fbos[MAX_CASCADES] = {};
+    ShadowCache caches[MAX_CASCADES];
+    int mapSize = 0;
+    glm::mat4 matrices[MAX_CASCADES] = { glm::mat4(1.0f), glm::mat4(1.0f), glm::mat4(1.0f), glm::mat4(1.0f) };
+    float splits[MAX_CASCADES] = {};
+
+    struct UniformLocations {
+        GLint matrices = -1, splits = -1, count = -1;
+    };
+    mutable GLuint uniformProgram = 0;
+    mutable UniformLocations uniforms;
+};
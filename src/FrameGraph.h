@@ -0,0 +1,117 @@
+// FrameGraph.h
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "JobSystem.h"
+
+// Per-frame CPU tasks with declared data dependencies. Each task names the
+// resources it reads and writes; add() orders it after the last writer of
+// everything it reads, and after the last writer and every reader since of
+// everything it writes, so declaration order is the serial order and a new
+// system only waits for the data it touches. run() starts every task whose
+// inputs are ready as a job and returns when all have run.
+//
+// Resources are plain names ("locals", "worlds", ...). Tasks must not make
+// GL calls; the caller submits once run() returns.
+class FrameGraph {
+public:
+    typedef uint32_t TaskId;
+
+    TaskId add(const char* name, std::initializer_list<const char*> reads,
+               std::initializer_list<const char*> writes, std::function<void()> fn) {
+        TaskId id = (TaskId)tasks.size();
+        tasks.push_back(Task());
+        Task& task = tasks.back();
+        task.name = name;
+        task.fn = std::move(fn);
+
+        for (const char* r : reads) {
+            Resource& res = resources[r];
+            dependOn(res.writer, id);
+            res.readers.push_back(id);
+        }
+        for (const char* w : writes) {
+            Resource& res = resources[w];
+            dependOn(res.writer, id);
+            for (TaskId reader : res.readers)
+                dependOn(reader, id);
+            res.readers.clear();
+            res.writer = id;
+        }
+        return id;
+    }
+
+    // Runs every task once on 'jobs'; the caller helps until all are done.
+    void run(JobSystem& jobs) {
+        remaining.reset(new std::atomic<uint32_t>[tasks.size()]);
+        for (size_t i = 0; i < tasks.size(); ++i)
+            remaining[i] = tasks[i].dependencies;
+
+        JobSystem::Counter counter;
+        for (TaskId i = 0; i < (TaskId)tasks.size(); ++i)
+            if (tasks[i].dependencies == 0)
+                schedule(jobs, counter, i);
+        jobs.wait(counter);
+    }
+
+    // Forgets tasks and resources, keeping their storage for the next frame.
+    void clear() {
+        tasks.clear();
+        for (auto& r : resources) {
+            r.second.writer = NONE;
+            r.second.readers.clear();
+        }
+    }
+
+    size_t taskCount() const { return tasks.size(); }
+    const char* taskName(TaskId id) const { return tasks[id].name; }
+    // Wall time of the task's last run.
+    double taskMs(TaskId id) const { return tasks[id].ms; }
+
+private:
+    static constexpr TaskId NONE = 0xffffffffu;
+
+    struct Task {
+        const char* name = "";
+        std::function<void()> fn;
+        std::vector<TaskId> successors;
+        uint32_t dependencies = 0;
+        double ms = 0.0;
+    };
+    struct Resource {
+        TaskId writer = NONE;
+        std::vector<TaskId> readers;    // since the last write
+    };
+
+    void dependOn(TaskId before, TaskId after) {
+        if (before == NONE || before == after) return;
+        std::vector<TaskId>& next = tasks[before].successors;
+        if (!next.empty() && next.back() == after) return;   // edges to 'after' are added together
+        next.push_back(after);
+        ++tasks[after].dependencies;
+    }
+
+    void schedule(JobSystem& jobs, JobSystem::Counter& counter, TaskId id) {
+        jobs.run(counter, [this, &jobs, &counter, id] {
+            Task& task = tasks[id];
+            auto t0 = std::chrono::steady_clock::now();
+            task.fn();
+            task.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            for (TaskId next : task.successors)
+                if (remaining[next].fetch_sub(1) == 1)
+                    schedule(jobs, counter, next);
+        });
+    }
+
+    std::vector<Task> tasks;
+    std::unordered_map<std::string, Resource> resources;
+    std::unique_ptr<std::atomic<uint32_t>[]> remaining;    // per task, during run()
+};
@@ -0,0 +1,75 @@
+// Frustum.h
+#pragma once
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+// World-space bounding sphere. A negative radius means unbounded: it
+// intersects every frustum.
+struct BoundingSphere {
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = -1.0f;
+
+    // The sphere (center, radius) in model space, under 'model'. The radius
+    // grows with the largest axis scale, so non-uniform scales stay covered.
+    static BoundingSphere transformed(const glm::vec3& center, float radius, const glm::mat4& model) {
+        BoundingSphere s;
+        s.center = glm::vec3(model * glm::vec4(center, 1.0f));
+        float scale = std::max(glm::length(glm::vec3(model[0])),
+                      std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+        s.radius = (radius < 0.0f) ? -1.0f : radius * scale;
+        return s;
+    }
+};
+
+// The six planes of a view-projection matrix (Gribb/Hartmann), normals
+// pointing inwards and normalised, so a plane's dot with a point is its
+// signed distance. Works for perspective and orthographic projections.
+struct Frustum {
+    glm::vec4 planes[6];    // left, right, bottom, top, near, far
+
+    Frustum() = default;
+    explicit Frustum(const glm::mat4& viewProjection) { set(viewProjection); }
+
+    void set(const glm::mat4& m) {
+        glm::vec4 row[4];
+        for (int r = 0; r < 4; ++r)
+            row[r] = glm::vec4(m[0][r], m[1][r], m[2][r], m[3][r]);
+        planes[0] = row[3] + row[0];
+        planes[1] = row[3] - row[0];
+        planes[2] = row[3] + row[1];
+        planes[3] = row[3] - row[1];
+        planes[4] = row[3] + row[2];
+        planes[5] = row[3] - row[2];
+        for (glm::vec4& p : planes)
+            p = p / glm::length(glm::vec3(p));
+    }
+
+    // Conservative: near the frustum's corners a sphere just outside two
+    // planes still counts as intersecting.
+    bool intersects(const BoundingSphere& s) const {
+        if (s.radius < 0.0f) return true;
+        for (const glm::vec4& p : planes)
+            if (glm::dot(glm::vec3(p), s.center) + p.w < -s.radius)
+                return false;
+        return true;
+    }
+};
+
+// Objects one pass tested against its frustum.
+struct CullStats {
+    size_t drawn = 0;
+    size_t culled = 0;
+
+    bool count(bool visible) {
+        if (visible) ++drawn; else ++culled;
+        return visible;
+    }
+    CullStats& operator+=(const CullStats& o) {
+        drawn += o.drawn;
+        culled += o.culled;
+        return *this;
+    }
+};
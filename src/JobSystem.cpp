@@ -0,0 +1,100 @@
+#include "JobSystem.h"
+
+namespace {
+// Which pool the current thread works for, and its deque there.
+thread_local const JobSystem* currentPool = nullptr;
+thread_local unsigned currentQueue = 0;
+}
+
+void JobSystem::startWorkers() {
+    unsigned hw = std::thread::hardware_concurrency();
+    unsigned n = threads ? threads : (hw > 1 ? hw - 1 : 1);
+    n = std::min(n, 15u);
+    stopping = false;
+    for (unsigned i = 0; i <= n; ++i)
+        queues.emplace_back(new Queue());
+    for (unsigned i = 1; i <= n; ++i)
+        workers.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+unsigned JobSystem::queueIndex() const {
+    return (currentPool == this) ? currentQueue : 0;
+}
+
+void JobSystem::run(Counter& counter, Job job) {
+    if (queues.empty())
+        startWorkers();
+
+    counter.pending.fetch_add(1);
+    queued.fetch_add(1);    // before the push, so runOne never takes it below zero
+    Queue& q = *queues[queueIndex()];
+    {
+        std::lock_guard<std::mutex> lock(q.mutex);
+        q.tasks.push_back({ std::move(job), &counter });
+    }
+    {
+        // pairs with the predicate check in workerLoop, so no wake-up is lost
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wake.notify_one();
+}
+
+// Pops the newest task of our own deque, else steals the oldest of another
+// one, and runs it. False if every deque was empty.
+bool JobSystem::runOne(unsigned self) {
+    Task task;
+    bool found = false;
+    const unsigned n = (unsigned)queues.size();
+    for (unsigned k = 0; k < n && !found; ++k) {
+        Queue& q = *queues[(self + k) % n];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.tasks.empty()) continue;
+        if (k == 0) {
+            task = std::move(q.tasks.back());
+            q.tasks.pop_back();
+        } else {
+            task = std::move(q.tasks.front());
+            q.tasks.pop_front();
+        }
+        found = true;
+    }
+    if (!found) return false;
+
+    queued.fetch_sub(1);
+    task.job();
+    task.counter->pending.fetch_sub(1);
+    return true;
+}
+
+void JobSystem::wait(Counter& counter) {
+    if (queues.empty()) return;     // nothing was ever run
+    const unsigned self = queueIndex();
+    while (counter.pending.load() > 0) {
+        if (!runOne(self))
+            std::this_thread::yield();  // the last jobs are running elsewhere
+    }
+}
+
+void JobSystem::workerLoop(unsigned self) {
+    currentPool = this;
+    currentQueue = self;
+    for (;;) {
+        if (runOne(self)) continue;
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this] { return stopping || queued.load() > 0; });
+        if (stopping && queued.load() == 0) return;
+    }
+}
+
+void JobSystem::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& t : workers)
+        t.join();
+    workers.clear();
+    queues.clear();
+    queued = 0;
+}
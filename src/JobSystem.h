@@ -0,0 +1,93 @@
+// JobSystem.h
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small work-stealing thread pool for per-frame CPU work. Every thread has
+// its own deque: it pushes and pops its jobs at the back, and an idle thread
+// steals from the front of another's, so a thread that spawns many jobs
+// keeps its cache-warm ones while the rest spread out. The thread that
+// calls wait() (normally the GL thread) runs jobs too instead of blocking.
+// Jobs must not make GL calls.
+class JobSystem {
+public:
+    typedef std::function<void()> Job;
+
+    // Jobs still to finish; wait() returns when it reaches zero.
+    struct Counter {
+        std::atomic<size_t> pending{0};
+    };
+
+    JobSystem() = default;
+    ~JobSystem() { shutdown(); }
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Worker threads besides the caller (0 = hardware threads - 1, capped
+    // at 15). Set before the first run().
+    unsigned threads = 0;
+
+    // Queues 'job' on the calling thread's deque; 'counter' counts it until
+    // it has run. Callable from jobs.
+    void run(Counter& counter, Job job);
+
+    // Runs jobs, own first, then stolen, until 'counter' reaches zero.
+    void wait(Counter& counter);
+
+    // f(begin, end) over [0, count) in chunks of at least 'grain', spread
+    // over the pool; returns when every chunk is done. Runs inline when
+    // there is only one chunk.
+    template <class F>
+    void parallelFor(size_t count, size_t grain, F&& f) {
+        grain = std::max<size_t>(grain, 1);
+        if (count <= grain) {
+            if (count) f((size_t)0, count);
+            return;
+        }
+        Counter counter;
+        for (size_t begin = 0; begin < count; begin += grain) {
+            size_t end = std::min(count, begin + grain);
+            run(counter, [&f, begin, end] { f(begin, end); });
+        }
+        wait(counter);
+    }
+
+    // Pool threads including the caller, once started.
+    unsigned concurrency() const { return (unsigned)queues.size(); }
+
+    // Stops the workers after the jobs already queued.
+    void shutdown();
+
+private:
+    struct Task {
+        Job job;
+        Counter* counter = nullptr;
+    };
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void startWorkers();
+    unsigned queueIndex() const;
+    bool runOne(unsigned self);
+    void workerLoop(unsigned self);
+
+    // queues[0] belongs to whichever non-worker thread calls in (the GL
+    // thread), queues[i] to workers[i - 1]
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> queued{0};      // tasks in all deques
+    std::mutex sleepMutex;
+    std::condition_variable wake;       // workers: queued > 0 or stopping
+    bool stopping = false;
+};
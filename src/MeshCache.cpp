@@ -0,0 +1,339 @@
+#include "MeshCache.h"
+#include "../OBJloader.h"
+#include "MeshFile.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "VertexWelder.h"
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+// ------- load-time fix-ups for OBJs without normals/UVs -------
+namespace {
+    bool hasAnyUVs(const std::vector<Vertex>& v) {
+        for (const auto& x : v) if (x.texCoord.x != 0.0f || x.texCoord.y != 0.0f) return true;
+        return false;
+    }
+
+    bool hasAnyNormals(const std::vector<Vertex>& v) {
+        for (const auto& x : v) if (glm::dot(x.normal, x.normal) > 1e-10f) return true;
+        return false;
+    }
+
+    void generateSphericalUVs(std::vector<Vertex>& v) {
+        for (auto& x : v) {
+            glm::vec3 p = glm::normalize(x.position);
+            float u = 0.5f + atan2f(p.z, p.x) / (2.0f * glm::pi<float>());
+            float vcoord = 0.5f - asinf(p.y) / glm::pi<float>();
+            x.texCoord = glm::vec2(u, vcoord);
+        }
+    }
+
+    void recomputeNormals(std::vector<Vertex>& v, const std::vector<unsigned int>& idx) {
+        for (auto& x : v) x.normal = glm::vec3(0.0f);
+        for (size_t i = 0; i + 2 < idx.size(); i += 3) {
+            Vertex& a = v[idx[i + 0]];
+            Vertex& b = v[idx[i + 1]];
+            Vertex& c = v[idx[i + 2]];
+            glm::vec3 n = glm::normalize(glm::cross(b.position - a.position, c.position - a.position));
+            if (!std::isfinite(n.x)) continue;
+            a.normal += n; b.normal += n; c.normal += n;
+        }
+        for (auto& x : v) {
+            float L2 = glm::dot(x.normal, x.normal);
+            x.normal = (L2 > 1e-12f) ? glm::normalize(x.normal) : glm::vec3(0, 1, 0);
+        }
+    }
+}
+
+const MeshHandle* MeshCache::load(const char* path) {
+    auto found = meshes.find(path);
+    if (found != meshes.end())
+        return &found->second;
+
+    MeshFileInfo info;
+    memset(&info, 0, sizeof(info));
+    info.packedVertices = packedVertices ? 1 : 0;
+    info.lodLevels = (uint32_t)std::min(std::max(lodLevels, 1), (int)MESH_MAX_LODS);
+    info.positionStride = (uint32_t)positionStride();
+    info.attributeStride = (uint32_t)attributeStride();
+
+    MeshHandle handle;
+    std::string cachePath = meshCachePath(path);
+    MeshFileView cached;
+    if (openMeshFile(cachePath.c_str(), path, info, cached)) {
+        // instant path: the mapped streams go straight into the shared buffers
+        handle = append(cached.header->info, cached.positions, cached.attributes, (size_t)cached.header->vertexCount,
+                        cached.indices, (size_t)cached.header->indexCount);
+    } else {
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        if (!buildFromOBJ(path, vertices, indices, info))
+            return nullptr;
+        std::vector<unsigned char> positionData, attributeData;
+        packStreams(vertices, info, positionData, attributeData);
+        if (!writeMeshFile(cachePath.c_str(), path, info, positionData.data(), attributeData.data(),
+                           vertices.size(), indices))
+            std::cerr << "Could not write mesh cache " << cachePath << std::endl;
+        handle = append(info, positionData.data(), attributeData.data(), vertices.size(),
+                        indices.data(), indices.size());
+    }
+    std::cout << path << ": " << handle.vertexCount << " vertices, "
+              << (handle.vertexCount * sizeof(Vertex)) / 1024 << " KB as floats -> "
+              << (handle.vertexCount * vertexStride()) / 1024 << " KB on the GPU ("
+              << (handle.vertexCount * positionStride()) / 1024 << " KB read by depth passes)" << std::endl;
+    std::cout << path << ": LOD triangles";
+    for (int i = 0; i < handle.lodCount; ++i) std::cout << " " << handle.lods[i].indexCount / 3;
+    std::cout << std::endl;
+    return &meshes.emplace(path, handle).first->second;
+}
+
+// Fills info.lods; builds info.lodLevels levels.
+bool MeshCache::buildFromOBJ(const char* path, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices,
+                             MeshFileInfo& info) {
+    std::vector<glm::vec3> positions, normals;
+    std::vector<glm::vec2> uvs;
+    std::vector<unsigned int> objIndices;
+    size_t triangleCount = 0;
+
+    // small files are parsed serially inside loadOBJParallel
+    if (!loadOBJParallel(path, positions, normals, uvs, objIndices, loadThreads, &triangleCount)) {
+        std::cerr << "Failed to load " << path << std::endl;
+        return false;
+    }
+
+    WeldStats weld = weldVertices(positions, normals, uvs, triangleCount, vertices, indices);
+    std::cout << path << ": welded " << weld.corners << " corners into " << weld.vertices
+              << " vertices in " << weld.milliseconds << " ms" << std::endl;
+
+    // Fix data if the OBJ lacked normals/UVs (the station has no UVs)
+    if (!hasAnyNormals(vertices)) recomputeNormals(vertices, indices);
+    if (!hasAnyUVs(vertices)) generateSphericalUVs(vertices);
+
+    // every mesh is drawn 7+ times a frame (shadow passes), so spend the time once here
+    VertexCacheStats vc = optimizeMesh(vertices, indices);
+    std::cout << path << ": ACMR " << vc.acmrBefore << " -> " << vc.acmrAfter
+              << " (FIFO " << VERTEX_CACHE_FIFO_SIZE << ") in " << vc.milliseconds << " ms" << std::endl;
+
+    // coarser levels reuse the vertices; their indices are appended after LOD0
+    MeshLodInfo& lods = info.lods;
+    memset(&lods, 0, sizeof(lods));
+    lods.count = 1;
+    lods.indexCount[0] = (uint32_t)indices.size();
+    SimplifyStats simplify;
+    std::vector<LodLevel> chain = buildLodChain(vertices, indices, (int)info.lodLevels - 1, 0.5f, &simplify);
+    for (LodLevel& level : chain) {
+        optimizeVertexCache(level.indices, vertices.size());
+        lods.indexCount[lods.count] = (uint32_t)level.indices.size();
+        lods.error[lods.count] = level.error;
+        ++lods.count;
+        indices.insert(indices.end(), level.indices.begin(), level.indices.end());
+    }
+    std::cout << path << ": built " << lods.count << " LODs in " << simplify.milliseconds << " ms" << std::endl;
+    return true;
+}
+
+// Bounds, bounding sphere and dequantisation into info, and the vertices in
+// the GPU format its strides describe. Packed positions are relative to the
+// mesh's bounds.
+void MeshCache::packStreams(const std::vector<Vertex>& vertices, MeshFileInfo& info,
+                            std::vector<unsigned char>& positionData, std::vector<unsigned char>& attributeData) const {
+    glm::vec3 lo(0.0f), hi(0.0f), center(0.0f);
+    float r2 = 0.0f;
+    if (!vertices.empty()) {
+        lo = hi = vertices[0].position;
+        for (const Vertex& v : vertices) {
+            lo = glm::min(lo, v.position);
+            hi = glm::max(hi, v.position);
+        }
+        center = 0.5f * (lo + hi);
+        for (const Vertex& v : vertices) {
+            glm::vec3 d = v.position - center;
+            r2 = std::max(r2, glm::dot(d, d));
+        }
+    }
+    PositionQuantization quant;
+    if (info.packedVertices) quant = quantizationForBounds(lo, hi);
+    for (int k = 0; k < 3; ++k) {
+        info.boundsMin[k] = lo[k];
+        info.boundsMax[k] = hi[k];
+        info.center[k] = center[k];
+        info.quantOffset[k] = quant.offset[k];
+        info.quantScale[k] = quant.scale[k];
+    }
+    info.radius = std::sqrt(r2);
+
+    size_t posStride = info.positionStride, attrStride = info.attributeStride;
+    positionData.assign(vertices.size() * posStride, 0);
+    attributeData.assign(vertices.size() * attrStride, 0);
+    unsigned char* pos = positionData.data();
+    unsigned char* attr = attributeData.data();
+    if (info.packedVertices) {
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            PackedPosition p = packPosition(vertices[i].position, quant);
+            PackedAttributes a = packAttributes(vertices[i]);
+            memcpy(pos + i * posStride, &p, sizeof(p));
+            memcpy(attr + i * attrStride, &a, sizeof(a));
+        }
+    } else {
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            memcpy(pos + i * posStride, &vertices[i].position, sizeof(glm::vec3));
+            memcpy(attr + i * attrStride, &vertices[i].texCoord, sizeof(glm::vec2));
+            memcpy(attr + i * attrStride + sizeof(glm::vec2), &vertices[i].normal, sizeof(glm::vec3));
+        }
+    }
+}
+
+// positions/attributes are streams in this cache's format (see packStreams),
+// e.g. straight from a mapped cache file.
+MeshHandle MeshCache::append(const MeshFileInfo& info, const void* positions, const void* attributes,
+                             size_t vertexCount, const unsigned int* indices, size_t indexCount) {
+    MeshHandle h;
+    size_t firstIndex = indexTotal;
+    h.lodCount = (int)info.lods.count;
+    size_t lodStart = firstIndex;
+    for (int i = 0; i < h.lodCount; ++i) {
+        h.lods[i].firstIndex = (GLuint)lodStart;
+        h.lods[i].indexCount = (GLsizei)info.lods.indexCount[i];
+        h.lods[i].error = info.lods.error[i];
+        lodStart += info.lods.indexCount[i];
+    }
+    h.indexCount = h.lods[0].indexCount;
+    h.firstIndex = h.lods[0].firstIndex;
+    h.baseVertex = (GLint)vertexTotal;
+    h.vertexCount = (GLuint)vertexCount;
+    h.boundsMin = glm::vec3(info.boundsMin[0], info.boundsMin[1], info.boundsMin[2]);
+    h.boundsMax = glm::vec3(info.boundsMax[0], info.boundsMax[1], info.boundsMax[2]);
+    h.center = glm::vec3(info.center[0], info.center[1], info.center[2]);
+    h.radius = info.radius;
+    h.packed = info.packedVertices != 0;
+    h.quant.offset = glm::vec3(info.quantOffset[0], info.quantOffset[1], info.quantOffset[2]);
+    h.quant.scale = glm::vec3(info.quantScale[0], info.quantScale[1], info.quantScale[2]);
+
+    upload(positions, attributes, vertexCount, indices, indexCount);
+    h.vao = sharedVAO;
+    return h;
+}
+
+void MeshCache::createBuffers() {
+    glGenVertexArrays(1, &sharedVAO);
+    glGenVertexArrays(1, &positionVAO);
+    glGenBuffers(1, &positionVBO);
+    glGenBuffers(1, &attributeVBO);
+    glGenBuffers(1, &sharedEBO);
+
+    setupVAO(sharedVAO, false);
+    setupVAO(positionVAO, true);
+}
+
+GLuint MeshCache::createVAO(bool depthOnly) const {
+    if (!sharedVAO) return 0;
+    GLuint vao = 0;
+    glGenVertexArrays(1, &vao);
+    setupVAO(vao, depthOnly);
+    return vao;
+}
+
+// Position stream at location 0; the scene layout also reads the attribute
+// stream (UV at 1, normal at 2).
+void MeshCache::setupVAO(GLuint vao, bool depthOnly) const {
+    GLsizei posStride = (GLsizei)positionStride(), attrStride = (GLsizei)attributeStride();
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sharedEBO);
+    glBindBuffer(GL_ARRAY_BUFFER, positionVBO);
+    if (packedVertices)
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, posStride, (void*)0);
+    else
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, posStride, (void*)0);
+    glEnableVertexAttribArray(0);
+
+    if (!depthOnly) {
+        glBindBuffer(GL_ARRAY_BUFFER, attributeVBO);
+        if (packedVertices) {
+            glVertexAttribPointer(1, 2, GL_HALF_FLOAT, GL_FALSE, attrStride, (void*)offsetof(PackedAttributes, u));
+            glVertexAttribPointer(2, 2, GL_SHORT, GL_TRUE, attrStride, (void*)offsetof(PackedAttributes, octX));
+        } else {
+            glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, attrStride, (void*)0);
+            glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, attrStride, (void*)sizeof(glm::vec2));
+        }
+        glEnableVertexAttribArray(1);
+        glEnableVertexAttribArray(2);
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Appends one mesh after the ones already on the GPU. Buffers grow
+// geometrically; the meshes already uploaded are copied over on the GPU, so
+// no CPU copy has to be kept.
+void MeshCache::upload(const void* positions, const void* attributes, size_t vertexCount,
+                       const unsigned int* indices, size_t indexCount) {
+    if (!sharedVAO)
+        createBuffers();
+
+    size_t posStride = positionStride(), attrStride = attributeStride();
+    if (vertexTotal + vertexCount > vertexCapacity) {
+        size_t capacity = std::max(vertexTotal + vertexCount, vertexCapacity * 2);
+        growBuffer(positionVBO, vertexTotal * posStride, capacity * posStride);
+        growBuffer(attributeVBO, vertexTotal * attrStride, capacity * attrStride);
+        vertexCapacity = capacity;
+    }
+    if (indexTotal + indexCount > indexCapacity) {
+        size_t capacity = std::max(indexTotal + indexCount, indexCapacity * 2);
+        growBuffer(sharedEBO, indexTotal * sizeof(unsigned int), capacity * sizeof(unsigned int));
+        indexCapacity = capacity;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, positionVBO);
+    glBufferSubData(GL_ARRAY_BUFFER, vertexTotal * posStride, vertexCount * posStride, positions);
+    glBindBuffer(GL_ARRAY_BUFFER, attributeVBO);
+    glBufferSubData(GL_ARRAY_BUFFER, vertexTotal * attrStride, vertexCount * attrStride, attributes);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    // the element buffer is VAO state; a copy target leaves every VAO alone
+    glBindBuffer(GL_COPY_WRITE_BUFFER, sharedEBO);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, indexTotal * sizeof(unsigned int), indexCount * sizeof(unsigned int), indices);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    vertexTotal += vertexCount;
+    indexTotal += indexCount;
+}
+
+// Reallocates buffer to newBytes, keeping its first usedBytes. The name does
+// not change, so every VAO built on it (createVAO() ones included) stays
+// valid; the old contents make a round trip through a scratch buffer.
+void MeshCache::growBuffer(GLuint buffer, size_t usedBytes, size_t newBytes) {
+    GLuint scratch = 0;
+    if (usedBytes) {
+        glGenBuffers(1, &scratch);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, scratch);
+        glBufferData(GL_COPY_WRITE_BUFFER, usedBytes, nullptr, GL_STREAM_COPY);
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, usedBytes);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, newBytes, nullptr, GL_STATIC_DRAW);
+    if (scratch) {
+        glBindBuffer(GL_COPY_READ_BUFFER, scratch);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, usedBytes);
+        glDeleteBuffers(1, &scratch);
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void MeshCache::release() {
+    if (sharedEBO) glDeleteBuffers(1, &sharedEBO);
+    if (attributeVBO) glDeleteBuffers(1, &attributeVBO);
+    if (positionVBO) glDeleteBuffers(1, &positionVBO);
+    if (positionVAO) glDeleteVertexArrays(1, &positionVAO);
+    if (sharedVAO) glDeleteVertexArrays(1, &sharedVAO);
+    sharedVAO = positionVAO = 0;
+    positionVBO = attributeVBO = sharedEBO = 0;
+    vertexCapacity = indexCapacity = 0;
+    vertexTotal = indexTotal = 0;
+    meshes.clear();
+}
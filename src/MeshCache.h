@@ -0,0 +1,173 @@
+// MeshCache.h
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Frustum.h"
+#include "MeshFile.h"
+#include "Vertex.h"
+#include "VertexPacking.h"
+
+// Generic attribute slots carrying the per-mesh position dequantisation
+// (see vertexShader.glsl). High slots keep 0..13 free for regular attributes.
+const GLuint ATTRIB_POS_SCALE = 14;
+const GLuint ATTRIB_POS_OFFSET = 15;
+
+// Camera terms for LOD selection; refresh once per frame.
+struct LodView {
+    glm::vec3 cameraPos = glm::vec3(0.0f);
+    float pixelsPerUnit = 1.0f;   // pixels covered by one world unit at distance 1
+    float maxPixelError = 1.0f;   // coarsest LOD whose projected error stays below this
+
+    void set(const glm::vec3& camPos, float fovyRadians, int framebufferHeight) {
+        cameraPos = camPos;
+        pixelsPerUnit = (float)framebufferHeight / (2.0f * tanf(0.5f * fovyRadians));
+    }
+};
+
+// One level of detail: an index range into the shared element buffer. All
+// levels of a mesh index the same vertices.
+struct MeshLod {
+    GLuint  firstIndex = 0;
+    GLsizei indexCount = 0;
+    float   error = 0.0f;   // model units, 0 for LOD0
+};
+
+// A mesh inside the shared buffers. Every mesh of a MeshCache uses the same
+// VAO, so a pass binds it once and then issues draw() per object.
+struct MeshHandle {
+    GLuint    vao = 0;          // shared VAO of the owning cache
+    GLsizei   indexCount = 0;       // LOD0
+    GLuint    firstIndex = 0;   // offset into the shared element buffer
+    GLint     baseVertex = 0;   // added to every index of this mesh
+    GLuint    vertexCount = 0;
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+    glm::vec3 center = glm::vec3(0.0f);   // bounding sphere in model space
+    float     radius = 0.0f;
+    bool      packed = false;       // quantised positions, decode with 'quant'
+    PositionQuantization quant;
+    MeshLod   lods[MESH_MAX_LODS];
+    int       lodCount = 1;
+
+    // Bounding sphere in world space, for culling.
+    BoundingSphere worldBounds(const glm::mat4& model) const {
+        return BoundingSphere::transformed(center, radius, model);
+    }
+
+    // Coarsest LOD whose error, projected at the mesh's nearest point, stays
+    // under view.maxPixelError. Inside the bounding sphere -> LOD0.
+    int selectLod(const glm::mat4& model, const LodView& view) const {
+        glm::vec3 worldCenter = glm::vec3(model * glm::vec4(center, 1.0f));
+        float scale = std::max(glm::length(glm::vec3(model[0])),
+                      std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+        float distance = glm::length(worldCenter - view.cameraPos) - radius * scale;
+        if (distance <= 0.0f) return 0;
+        int lod = 0;
+        while (lod + 1 < lodCount &&
+               lods[lod + 1].error * scale / distance * view.pixelsPerUnit <= view.maxPixelError)
+            ++lod;
+        return lod;
+    }
+
+    // Assumes one of the cache's VAOs is bound. Packed meshes pass their
+    // dequantisation as generic attributes and reset them afterwards, so
+    // float VAOs drawn with the same shaders keep decoding as plain floats.
+    void draw(int lod = 0) const {
+        const MeshLod& l = lods[lod];
+        if (packed) {
+            glVertexAttrib4f(ATTRIB_POS_SCALE, quant.scale.x, quant.scale.y, quant.scale.z, 0.0f);
+            glVertexAttrib3f(ATTRIB_POS_OFFSET, quant.offset.x, quant.offset.y, quant.offset.z);
+        }
+        glDrawElementsBaseVertex(GL_TRIANGLES, l.indexCount, GL_UNSIGNED_INT,
+                                 (void*)(sizeof(unsigned int) * (size_t)l.firstIndex), baseVertex);
+        if (packed)
+            glVertexAttrib4f(ATTRIB_POS_SCALE, 0.0f, 0.0f, 0.0f, 1.0f);
+    }
+
+    // As draw(), for instanceCount copies; per-instance attributes come from
+    // the bound VAO (see MeshCache::createVAO).
+    void drawInstanced(int lod, GLsizei instanceCount) const {
+        const MeshLod& l = lods[lod];
+        if (packed) {
+            glVertexAttrib4f(ATTRIB_POS_SCALE, quant.scale.x, quant.scale.y, quant.scale.z, 0.0f);
+            glVertexAttrib3f(ATTRIB_POS_OFFSET, quant.offset.x, quant.offset.y, quant.offset.z);
+        }
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, l.indexCount, GL_UNSIGNED_INT,
+                                          (void*)(sizeof(unsigned int) * (size_t)l.firstIndex),
+                                          instanceCount, baseVertex);
+        if (packed)
+            glVertexAttrib4f(ATTRIB_POS_SCALE, 0.0f, 0.0f, 0.0f, 1.0f);
+    }
+};
+
+// Loads each OBJ path once and packs all meshes into shared buffers: a
+// position stream, an attribute stream (UV + normal) and one EBO.
+// A repeated load() of the same path returns the existing handle.
+class MeshCache {
+public:
+    // Worker threads used for OBJ parsing (0 = all hardware threads).
+    unsigned loadThreads = 0;
+
+    // LODs built per mesh (including LOD0), each with ~half the triangles of the previous.
+    int lodLevels = MESH_MAX_LODS;
+
+    // Upload VertexPacking.h streams (16 bytes/vertex) instead of full floats
+    // (32 bytes/vertex). Set before the first load(). Both settings are
+    // recorded in the .meshbin caches; a cache built with others is rebuilt.
+    bool packedVertices = true;
+
+    // Returns nullptr if the file cannot be loaded. The pointer stays valid
+    // for the lifetime of the cache. Requires a current GL context.
+    const MeshHandle* load(const char* path);
+
+    GLuint vao() const { return sharedVAO; }
+    void bind() const { glBindVertexArray(sharedVAO); }
+
+    // Position stream only, for depth-only passes.
+    GLuint depthVAO() const { return positionVAO; }
+    void bindDepthOnly() const { glBindVertexArray(positionVAO); }
+
+    // A new VAO over the shared streams and element buffer (position stream
+    // only when depthOnly), for callers that add their own per-instance
+    // attributes. The caller deletes it. Valid after the first load().
+    GLuint createVAO(bool depthOnly) const;
+
+    // Bytes per vertex on the GPU (both streams / position stream only).
+    size_t vertexStride() const { return positionStride() + attributeStride(); }
+    size_t positionStride() const { return packedVertices ? sizeof(PackedPosition) : sizeof(glm::vec3); }
+    size_t attributeStride() const { return packedVertices ? sizeof(PackedAttributes) : sizeof(glm::vec2) + sizeof(glm::vec3); }
+
+    // Totals over every loaded mesh. Only the GPU holds the data; indices
+    // are mesh-local (see baseVertex) and a mesh's LODs follow each other.
+    size_t vertexCount() const { return vertexTotal; }
+    size_t indexCount() const { return indexTotal; }
+
+    // Deletes the GL objects; call while the context is still current.
+    void release();
+
+private:
+    bool buildFromOBJ(const char* path, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices,
+                      MeshFileInfo& info);
+    void packStreams(const std::vector<Vertex>& vertices, MeshFileInfo& info,
+                     std::vector<unsigned char>& positionData, std::vector<unsigned char>& attributeData) const;
+    MeshHandle append(const MeshFileInfo& info, const void* positions, const void* attributes,
+                      size_t vertexCount, const unsigned int* indices, size_t indexCount);
+    void createBuffers();
+    void setupVAO(GLuint vao, bool depthOnly) const;
+    void upload(const void* positions, const void* attributes, size_t vertexCount,
+                const unsigned int* indices, size_t indexCount);
+    static void growBuffer(GLuint buffer, size_t usedBytes, size_t newBytes);
+
+    std::unordered_map<std::string, MeshHandle> meshes;
+    size_t vertexTotal = 0, indexTotal = 0;         // in use, in elements
+
+    GLuint sharedVAO = 0, positionVAO = 0;
+    GLuint positionVBO = 0, attributeVBO = 0, sharedEBO = 0;
+    size_t vertexCapacity = 0, indexCapacity = 0;  // GPU allocation, in elements
+};
@@ -0,0 +1,183 @@
+// MeshFile.h
+// Binary mesh cache written next to an OBJ ("<model>.obj.meshbin").
+// Layout: MeshFileHeader | position stream | attribute stream | uint32 index[indexCount]
+// The streams are in the GPU format MeshCache uploads (packed or float, see
+// VertexPacking.h), so a cached mesh goes from the mapping into the buffers
+// as is. The index array holds every LOD back to back (see MeshLodInfo).
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include "MappedFile.h"
+
+// Bump whenever the loaders produce different vertex/index data for the same
+// OBJ (parser, welding, reordering or packing changes) so stale caches get rebuilt.
+const uint32_t MESH_FILE_VERSION = 5;  // 2: normal/UV fix-ups baked in, 3: vertex cache order, 4: LODs,
+                                       // 5: GPU-format streams
+
+
+const uint32_t MESH_MAX_LODS = 4;
+
+// Index counts of each LOD in the concatenated index array, LOD0 first.
+// Plain data so it can live in the memset/fwrite'd header.
+struct MeshLodInfo {
+    uint32_t count;
+    uint32_t indexCount[MESH_MAX_LODS];
+    float    error[MESH_MAX_LODS];   // simplification error, model units
+};
+
+// Everything MeshCache uploads a mesh with besides its streams. The first
+// four fields are the settings the streams were built with; a file built
+// with other settings is rebuilt.
+struct MeshFileInfo {
+    uint32_t packedVertices;    // MeshCache::packedVertices
+    uint32_t lodLevels;         // MeshCache::lodLevels, clamped to 1..MESH_MAX_LODS
+    uint32_t positionStride;    // bytes per vertex in each stream
+    uint32_t attributeStride;
+    float    boundsMin[3];
+    float    boundsMax[3];
+    float    center[3];         // bounding sphere
+    float    radius;
+    float    quantOffset[3];    // position dequantisation when packed
+    float    quantScale[3];
+    MeshLodInfo lods;
+};
+
+struct MeshFileHeader {
+    char     magic[4];       // "MBIN"
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t reserved;
+    uint64_t vertexCount;
+    uint64_t indexCount;
+    uint64_t sourceSize;     // OBJ size/mtime: cheap staleness check
+    int64_t  sourceMTime;
+    uint64_t sourceHash;     // OBJ content hash, checked when size/mtime differ
+    MeshFileInfo info;
+};
+
+// A validated cache file. positions/attributes/indices point into the
+// mapping and stay valid as long as the MeshFileView is alive.
+struct MeshFileView {
+    MappedFile file;
+    const MeshFileHeader* header = nullptr;
+    const unsigned char* positions = nullptr;
+    const unsigned char* attributes = nullptr;
+    const uint32_t* indices = nullptr;
+};
+
+inline std::string meshCachePath(const char* objPath) {
+    return std::string(objPath) + ".meshbin";
+}
+
+// 64-bit content hash, 8 bytes per step (not cryptographic).
+inline uint64_t hashBytes(const char* data, size_t size) {
+    const uint64_t M = 0x9E3779B97F4A7C15ull;
+    uint64_t h = 0xCBF29CE484222325ull ^ (size * M);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t w;
+        memcpy(&w, data + i, 8);
+        h = (h ^ (w * M)) * 0xFF51AFD7ED558CCDull;
+        h ^= h >> 32;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, data + i, size - i);
+    h = (h ^ (tail * M)) * 0xC4CEB9FE1A85EC53ull;
+    return h ^ (h >> 29);
+}
+
+inline bool statSource(const char* path, uint64_t& size, int64_t& mtime) {
+    struct stat st;
+    if (stat(path, &st) != 0) return false;
+    size = (uint64_t)st.st_size;
+    mtime = (int64_t)st.st_mtime;
+    return true;
+}
+
+// Maps cachePath and checks it against the OBJ at sourcePath and the settings
+// in the first four fields of 'settings'. Returns false if the cache is
+// missing, truncated, from another version or other settings, or stale.
+inline bool openMeshFile(const char* cachePath, const char* sourcePath, const MeshFileInfo& settings,
+                         MeshFileView& view) {
+    // unmap on rejection so the caller can overwrite the file
+    auto reject = [&view]() { view.file.close(); return false; };
+
+    if (!view.file.open(cachePath)) return false;
+    if (view.file.size() < sizeof(MeshFileHeader)) return reject();
+
+    const MeshFileHeader* h = reinterpret_cast<const MeshFileHeader*>(view.file.data());
+    if (memcmp(h->magic, "MBIN", 4) != 0 || h->version != MESH_FILE_VERSION ||
+        h->headerSize != sizeof(MeshFileHeader))
+        return reject();
+    const MeshFileInfo& info = h->info;
+    if (info.packedVertices != settings.packedVertices || info.lodLevels != settings.lodLevels ||
+        info.positionStride != settings.positionStride || info.attributeStride != settings.attributeStride)
+        return reject();
+    uint64_t streamBytes = h->vertexCount * (info.positionStride + info.attributeStride);
+    uint64_t expected = sizeof(MeshFileHeader) + streamBytes + h->indexCount * sizeof(uint32_t);
+    if (view.file.size() != expected || streamBytes % sizeof(uint32_t) != 0) return reject();
+    uint64_t lodIndices = 0;
+    for (uint32_t i = 0; i < info.lods.count && i < MESH_MAX_LODS; ++i) lodIndices += info.lods.indexCount[i];
+    if (info.lods.count < 1 || info.lods.count > MESH_MAX_LODS || lodIndices != h->indexCount) return reject();
+
+    uint64_t srcSize = 0;
+    int64_t srcMTime = 0;
+    if (statSource(sourcePath, srcSize, srcMTime) &&
+        (srcSize != h->sourceSize || srcMTime != h->sourceMTime)) {
+        // touched (e.g. by a checkout) - only stale if the content changed
+        MappedFile src(sourcePath);
+        if (!src.isOpen() || src.size() != h->sourceSize ||
+            hashBytes(src.data(), src.size()) != h->sourceHash)
+            return reject();
+    }
+
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(view.file.data());
+    view.header = h;
+    view.positions = data + sizeof(MeshFileHeader);
+    view.attributes = view.positions + h->vertexCount * info.positionStride;
+    view.indices = reinterpret_cast<const uint32_t*>(view.attributes + h->vertexCount * info.attributeStride);
+    return true;
+}
+
+// Writes the cache atomically (temp file + rename). Failure is not fatal for
+// the caller; the mesh is simply re-parsed next launch.
+inline bool writeMeshFile(const char* cachePath, const char* sourcePath, const MeshFileInfo& info,
+                          const void* positions, const void* attributes, size_t vertexCount,
+                          const std::vector<unsigned int>& indices) {
+    MeshFileHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, "MBIN", 4);
+    h.version = MESH_FILE_VERSION;
+    h.headerSize = sizeof(MeshFileHeader);
+    h.vertexCount = vertexCount;
+    h.indexCount = indices.size();
+    h.info = info;
+
+    {
+        MappedFile src(sourcePath);
+        if (!src.isOpen()) return false;
+        h.sourceHash = hashBytes(src.data(), src.size());
+    }
+    if (!statSource(sourcePath, h.sourceSize, h.sourceMTime)) return false;
+
+    std::string tmp = std::string(cachePath) + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "wb");
+    if (!f) return false;
+    static_assert(sizeof(unsigned int) == sizeof(uint32_t), "index type must be 32-bit");
+    bool ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+              fwrite(positions, info.positionStride, vertexCount, f) == vertexCount &&
+              fwrite(attributes, info.attributeStride, vertexCount, f) == vertexCount &&
+              fwrite(indices.data(), sizeof(uint32_t), indices.size(), f) == indices.size();
+    ok = (fclose(f) == 0) && ok;
+    if (ok) {
+        remove(cachePath); // rename() does not replace on Windows
+        ok = rename(tmp.c_str(), cachePath) == 0;
+    }
+    if (!ok) remove(tmp.c_str());
+    return ok;
+}
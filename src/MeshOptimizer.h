@@ -0,0 +1,205 @@
+// MeshOptimizer.h
+// Post-load index/vertex reordering for welded meshes (see VertexWelder.h).
+// Triangles are reordered for post-transform cache reuse (Forsyth's linear-speed
+// algorithm), then vertices are renumbered in first-use order.
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "Vertex.h"
+
+struct VertexCacheStats {
+    double acmrBefore = 0.0;   // average cache misses per triangle (~0.5 best, 3.0 worst)
+    double acmrAfter = 0.0;
+    double milliseconds = 0.0;
+};
+
+// Simulated FIFO post-transform cache size used for ACMR reporting. Real GPUs
+// differ, but the ranking of orders is stable across 16-32 entries.
+const unsigned VERTEX_CACHE_FIFO_SIZE = 16;
+
+// Average cache misses per triangle for a FIFO cache of cacheSize entries.
+inline double computeACMR(const std::vector<unsigned int>& indices, size_t vertexCount,
+                          unsigned cacheSize = VERTEX_CACHE_FIFO_SIZE) {
+    if (indices.size() < 3) return 0.0;
+    // a vertex is in the cache if it was pushed within the last cacheSize misses
+    std::vector<uint32_t> stamp(vertexCount, 0);
+    uint32_t time = cacheSize + 1;
+    size_t misses = 0;
+    for (unsigned int v : indices) {
+        if (time - stamp[v] > cacheSize) {
+            stamp[v] = time++;
+            ++misses;
+        }
+    }
+    return (double)misses / (double)(indices.size() / 3);
+}
+
+namespace forsyth {
+    const int CACHE_SIZE = 32;        // modelled LRU cache, larger than the FIFO on purpose
+    const float CACHE_DECAY = 1.5f;
+    const float LAST_TRI_SCORE = 0.75f;
+    const float VALENCE_SCALE = 2.0f;
+    const float VALENCE_POWER = 0.5f;
+    const int MAX_VALENCE_TABLE = 32;
+
+    struct Tables {
+        float cache[CACHE_SIZE];
+        float valence[MAX_VALENCE_TABLE];
+        Tables() {
+            for (int i = 0; i < CACHE_SIZE; ++i) {
+                if (i < 3) {
+                    cache[i] = LAST_TRI_SCORE; // avoid rewarding the triangle just emitted
+                } else {
+                    float s = 1.0f - (float)(i - 3) / (float)(CACHE_SIZE - 3);
+                    cache[i] = std::pow(s, CACHE_DECAY);
+                }
+            }
+            valence[0] = 0.0f;
+            for (int i = 1; i < MAX_VALENCE_TABLE; ++i)
+                valence[i] = VALENCE_SCALE * std::pow((float)i, -VALENCE_POWER);
+        }
+    };
+
+    inline const Tables& tables() {
+        static const Tables t;
+        return t;
+    }
+
+    // cachePos < 0: not in cache. remaining: triangles still to emit using the vertex.
+    inline float vertexScore(int cachePos, uint32_t remaining) {
+        if (remaining == 0) return -1.0f;
+        const Tables& t = tables();
+        float score = (cachePos >= 0) ? t.cache[cachePos] : 0.0f;
+        score += (remaining < (uint32_t)MAX_VALENCE_TABLE)
+                 ? t.valence[remaining]
+                 : VALENCE_SCALE * std::pow((float)remaining, -VALENCE_POWER);
+        return score;
+    }
+}
+
+// Reorders triangles in place for vertex-cache locality. O(triangles * cache size).
+inline void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount) {
+    using namespace forsyth;
+    const size_t triCount = indices.size() / 3;
+    if (triCount == 0 || vertexCount == 0) return;
+
+    // vertex -> triangle adjacency (CSR)
+    std::vector<uint32_t> remaining(vertexCount, 0);
+    for (size_t i = 0; i < triCount * 3; ++i) ++remaining[indices[i]];
+    std::vector<uint32_t> adjStart(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v) adjStart[v + 1] = adjStart[v] + remaining[v];
+    std::vector<uint32_t> adj(triCount * 3);
+    {
+        std::vector<uint32_t> fill(adjStart.begin(), adjStart.end() - 1);
+        for (size_t t = 0; t < triCount; ++t)
+            for (int k = 0; k < 3; ++k) adj[fill[indices[t * 3 + k]]++] = (uint32_t)t;
+    }
+
+    std::vector<int> cachePos(vertexCount, -1);
+    std::vector<float> vScore(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) vScore[v] = vertexScore(-1, remaining[v]);
+
+    std::vector<float> tScore(triCount);
+    std::vector<uint8_t> emitted(triCount, 0);
+    for (size_t t = 0; t < triCount; ++t)
+        tScore[t] = vScore[indices[t * 3]] + vScore[indices[t * 3 + 1]] + vScore[indices[t * 3 + 2]];
+
+    std::vector<unsigned int> out;
+    out.reserve(triCount * 3);
+
+    int cache[CACHE_SIZE + 3];
+    int cacheCount = 0;
+    size_t scan = 0;  // fallback cursor for when the cache holds no live triangle
+    long best = -1;
+
+    for (size_t emittedCount = 0; emittedCount < triCount; ++emittedCount) {
+        if (best < 0) {
+            // restart: highest scoring unemitted triangle would be ideal, the
+            // next one in input order is nearly as good and keeps this linear
+            while (emitted[scan]) ++scan;
+            best = (long)scan;
+        }
+
+        const unsigned int* tri = &indices[(size_t)best * 3];
+        emitted[best] = 1;
+        out.insert(out.end(), tri, tri + 3);
+
+        // move the triangle's vertices to the front of the LRU cache
+        int newCache[CACHE_SIZE + 3];
+        int n = 0;
+        for (int k = 0; k < 3; ++k) {
+            unsigned int v = tri[k];
+            newCache[n++] = (int)v;
+            --remaining[v];
+            // unlink the triangle from the vertex adjacency
+            uint32_t* a = &adj[adjStart[v]];
+            uint32_t cnt = remaining[v] + 1;
+            for (uint32_t j = 0; j < cnt; ++j)
+                if (a[j] == (uint32_t)best) { a[j] = a[cnt - 1]; break; }
+        }
+        for (int i = 0; i < cacheCount; ++i) {
+            int v = cache[i];
+            if (v != (int)tri[0] && v != (int)tri[1] && v != (int)tri[2]) newCache[n++] = v;
+        }
+        for (int i = CACHE_SIZE; i < n; ++i) cachePos[newCache[i]] = -1; // fell out
+        cacheCount = std::min(n, CACHE_SIZE);
+        for (int i = 0; i < cacheCount; ++i) {
+            cache[i] = newCache[i];
+            cachePos[cache[i]] = i;
+        }
+
+        // rescore vertices that changed and their triangles; pick the next best
+        // triangle among those touching the cache
+        for (int i = n - 1; i >= 0; --i) {
+            int v = newCache[i];
+            float s = vertexScore(cachePos[v], remaining[v]);
+            float delta = s - vScore[v];
+            vScore[v] = s;
+            for (uint32_t j = 0; j < remaining[v]; ++j) tScore[adj[adjStart[v] + j]] += delta;
+        }
+        best = -1;
+        float bestScore = -1.0f;
+        for (int i = 0; i < cacheCount; ++i) {
+            int v = cache[i];
+            for (uint32_t j = 0; j < remaining[v]; ++j) {
+                uint32_t t = adj[adjStart[v] + j];
+                if (tScore[t] > bestScore) { bestScore = tScore[t]; best = (long)t; }
+            }
+        }
+    }
+
+    indices.swap(out);
+}
+
+// Renumbers vertices in the order the index buffer first references them, so
+// vertex fetches walk the VBO roughly sequentially. Unreferenced vertices are dropped.
+inline void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices) {
+    const uint32_t UNUSED = 0xFFFFFFFFu;
+    std::vector<uint32_t> remap(vertices.size(), UNUSED);
+    std::vector<Vertex> out;
+    out.reserve(vertices.size());
+    for (unsigned int& i : indices) {
+        if (remap[i] == UNUSED) {
+            remap[i] = (uint32_t)out.size();
+            out.push_back(vertices[i]);
+        }
+        i = remap[i];
+    }
+    vertices.swap(out);
+}
+
+// Both passes plus ACMR before/after.
+inline VertexCacheStats optimizeMesh(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices) {
+    auto t0 = std::chrono::steady_clock::now();
+    VertexCacheStats stats;
+    stats.acmrBefore = computeACMR(indices, vertices.size());
+    optimizeVertexCache(indices, vertices.size());
+    optimizeVertexFetch(vertices, indices);
+    stats.acmrAfter = computeACMR(indices, vertices.size());
+    stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    return stats;
+}
@@ -0,0 +1,304 @@
+// MeshSimplifier.h
+// Quadric error metric simplification (Garland & Heckbert) for welded meshes.
+// Half-edge collapses only: every LOD indexes the original vertex array, so
+// all levels of a mesh share one vertex buffer and differ only in indices.
+#pragma once
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+#include "Vertex.h"
+
+struct LodLevel {
+    std::vector<unsigned int> indices;
+    float error = 0.0f;   // RMS distance to the original surface, model units (estimate)
+};
+
+struct SimplifyStats {
+    size_t triangles = 0;        // input triangles
+    size_t lockedVertices = 0;   // open-border positions that never move
+    double milliseconds = 0.0;
+};
+
+namespace qem {
+    // Symmetric 4x4 plane quadric, area weighted. Error is normalised by the
+    // accumulated weight, so it reads as a mean squared distance.
+    struct Quadric {
+        double a2 = 0, ab = 0, ac = 0, ad = 0, b2 = 0, bc = 0, bd = 0, c2 = 0, cd = 0, d2 = 0, w = 0;
+
+        void addPlane(const glm::dvec3& n, double d, double weight) {
+            a2 += weight * n.x * n.x; ab += weight * n.x * n.y; ac += weight * n.x * n.z; ad += weight * n.x * d;
+            b2 += weight * n.y * n.y; bc += weight * n.y * n.z; bd += weight * n.y * d;
+            c2 += weight * n.z * n.z; cd += weight * n.z * d;
+            d2 += weight * d * d;
+            w += weight;
+        }
+        void add(const Quadric& q) {
+            a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad; b2 += q.b2; bc += q.bc; bd += q.bd;
+            c2 += q.c2; cd += q.cd; d2 += q.d2; w += q.w;
+        }
+        double eval(const glm::vec3& p) const {
+            double x = p.x, y = p.y, z = p.z;
+            double e = a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x
+                     + b2 * y * y + 2 * bc * y * z + 2 * bd * y
+                     + c2 * z * z + 2 * cd * z + d2;
+            return (w > 0.0) ? std::max(0.0, e) / w : 0.0;
+        }
+    };
+
+    struct Collapse {
+        double cost;
+        uint32_t from, to;          // position classes
+        uint32_t fromVersion, toVersion;
+        bool operator<(const Collapse& o) const { return cost > o.cost; } // min-heap
+    };
+
+    struct PositionKey {
+        float x, y, z;
+        bool operator==(const PositionKey& o) const { return memcmp(this, &o, sizeof(*this)) == 0; }
+    };
+    struct PositionKeyHash {
+        size_t operator()(const PositionKey& k) const {
+            uint32_t w[3];
+            memcpy(w, &k, sizeof(w));
+            uint64_t h = (w[0] * 0x9E3779B97F4A7C15ull) ^ (w[1] * 0xC2B2AE3D27D4EB4Full) ^ (w[2] * 0x165667B19E3779F9ull);
+            return (size_t)(h ^ (h >> 31));
+        }
+    };
+}
+
+// Builds coarser levels of (vertices, indices). Each level keeps ~ratio of the
+// previous level's triangles; up to maxLevels are returned (LOD0 not included).
+// Stops early when the mesh cannot be reduced further without crossing an
+// open border, a UV/normal seam or flipping a triangle.
+inline std::vector<LodLevel> buildLodChain(const std::vector<Vertex>& vertices,
+                                           const std::vector<unsigned int>& indices,
+                                           int maxLevels, float ratio = 0.5f,
+                                           SimplifyStats* outStats = nullptr) {
+    using namespace qem;
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<LodLevel> levels;
+    const size_t triCount = indices.size() / 3;
+    SimplifyStats stats;
+    stats.triangles = triCount;
+    if (triCount == 0 || maxLevels <= 0) {
+        if (outStats) *outStats = stats;
+        return levels;
+    }
+
+    // --- position classes: wedges (same position, different UV/normal) share one
+    std::vector<uint32_t> cls(vertices.size());
+    std::vector<uint32_t> classRep;              // class -> one vertex with that position
+    {
+        std::unordered_map<PositionKey, uint32_t, PositionKeyHash> ids;
+        ids.reserve(vertices.size());
+        for (size_t v = 0; v < vertices.size(); ++v) {
+            const glm::vec3& p = vertices[v].position;
+            PositionKey k = { p.x + 0.0f, p.y + 0.0f, p.z + 0.0f };
+            auto it = ids.emplace(k, (uint32_t)classRep.size());
+            if (it.second) classRep.push_back((uint32_t)v);
+            cls[v] = it.first->second;
+        }
+    }
+    const size_t classCount = classRep.size();
+    auto pos = [&](uint32_t c) -> const glm::vec3& { return vertices[classRep[c]].position; };
+
+    std::vector<unsigned int> tris(indices.begin(), indices.begin() + triCount * 3);
+    std::vector<uint8_t> alive(triCount, 1);
+    size_t aliveCount = 0;
+
+    // --- class -> triangle adjacency, quadrics, border edges
+    std::vector<std::vector<uint32_t>> adj(classCount);
+    std::vector<Quadric> quadric(classCount);
+    std::unordered_map<uint64_t, int> edgeUse;
+    edgeUse.reserve(triCount * 3);
+    for (size_t t = 0; t < triCount; ++t) {
+        uint32_t c[3] = { cls[tris[t * 3]], cls[tris[t * 3 + 1]], cls[tris[t * 3 + 2]] };
+        if (c[0] == c[1] || c[1] == c[2] || c[0] == c[2]) { alive[t] = 0; continue; }
+        ++aliveCount;
+        glm::dvec3 p0(pos(c[0])), p1(pos(c[1])), p2(pos(c[2]));
+        glm::dvec3 n = glm::cross(p1 - p0, p2 - p0);
+        double len = glm::length(n);
+        if (len > 0.0) {
+            n /= len;
+            double area = 0.5 * len;
+            for (int k = 0; k < 3; ++k) quadric[c[k]].addPlane(n, -glm::dot(n, p0), area);
+        }
+        for (int k = 0; k < 3; ++k) {
+            adj[c[k]].push_back((uint32_t)t);
+            uint32_t a = c[k], b = c[(k + 1) % 3];
+            if (a > b) std::swap(a, b);
+            ++edgeUse[((uint64_t)a << 32) | b];
+        }
+    }
+    std::vector<uint8_t> locked(classCount, 0);
+    for (const auto& e : edgeUse) {
+        if (e.second != 2) {
+            locked[(uint32_t)(e.first >> 32)] = 1;
+            locked[(uint32_t)e.first] = 1;
+        }
+    }
+    edgeUse.clear();
+
+    // classes with more than one wedge lie on an attribute seam
+    std::vector<uint8_t> wedgeCount(classCount, 0);
+    {
+        std::vector<uint8_t> seen(vertices.size(), 0);
+        for (size_t t = 0; t < triCount; ++t) {
+            if (!alive[t]) continue;
+            for (int k = 0; k < 3; ++k) {
+                unsigned int v = tris[t * 3 + k];
+                if (!seen[v]) { seen[v] = 1; if (wedgeCount[cls[v]] < 255) ++wedgeCount[cls[v]]; }
+            }
+        }
+    }
+    for (size_t c = 0; c < classCount; ++c) stats.lockedVertices += locked[c];
+
+    std::vector<uint32_t> version(classCount, 0);
+    std::vector<uint8_t> dead(classCount, 0);
+
+    // Wedge remap for collapsing 'from' onto 'to': each wedge of 'from' must share
+    // a live triangle with a wedge of 'to' (otherwise the collapse would tear a seam).
+    std::vector<std::pair<unsigned int, unsigned int>> remap;
+    auto buildRemap = [&](uint32_t from, uint32_t to) -> bool {
+        remap.clear();
+        for (uint32_t t : adj[from]) {
+            if (!alive[t]) continue;
+            const unsigned int* tri = &tris[t * 3];
+            unsigned int wFrom = 0, wTo = 0;
+            bool hasTo = false;
+            for (int k = 0; k < 3; ++k) {
+                if (cls[tri[k]] == from) wFrom = tri[k];
+                if (cls[tri[k]] == to) { wTo = tri[k]; hasTo = true; }
+            }
+            bool known = false;
+            for (auto& m : remap) if (m.first == wFrom) { known = true; break; }
+            if (!known) remap.push_back({ wFrom, hasTo ? wTo : 0xFFFFFFFFu });
+            else if (hasTo) for (auto& m : remap) if (m.first == wFrom && m.second == 0xFFFFFFFFu) m.second = wTo;
+        }
+        for (auto& m : remap) if (m.second == 0xFFFFFFFFu) return false;
+        return true;
+    };
+
+    // rejects collapses that flip or squash a surviving triangle
+    auto flips = [&](uint32_t from, uint32_t to) -> bool {
+        const glm::vec3& target = pos(to);
+        for (uint32_t t : adj[from]) {
+            if (!alive[t]) continue;
+            const unsigned int* tri = &tris[t * 3];
+            uint32_t c[3] = { cls[tri[0]], cls[tri[1]], cls[tri[2]] };
+            if (c[0] == to || c[1] == to || c[2] == to) continue; // removed by the collapse
+            glm::vec3 p[3] = { pos(c[0]), pos(c[1]), pos(c[2]) };
+            glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+            for (int k = 0; k < 3; ++k) if (c[k] == from) p[k] = target;
+            glm::vec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+            float lb = glm::length(before), la = glm::length(after);
+            if (la <= 1e-12f * std::max(1.0f, lb)) return true;
+            if (glm::dot(before, after) < 0.25f * lb * la) return true;
+        }
+        return false;
+    };
+
+    auto cost = [&](uint32_t from, uint32_t to) -> double {
+        Quadric q = quadric[from];
+        q.add(quadric[to]);
+        return q.eval(pos(to));
+    };
+
+    std::priority_queue<Collapse> heap;
+    std::vector<uint32_t> neighbours;
+    auto gatherNeighbours = [&](uint32_t c) {
+        neighbours.clear();
+        for (uint32_t t : adj[c]) {
+            if (!alive[t]) continue;
+            for (int k = 0; k < 3; ++k) {
+                uint32_t n = cls[tris[t * 3 + k]];
+                if (n != c && std::find(neighbours.begin(), neighbours.end(), n) == neighbours.end())
+                    neighbours.push_back(n);
+            }
+        }
+    };
+    auto pushEdge = [&](uint32_t from, uint32_t to) {
+        if (locked[from] || (wedgeCount[from] > 1 && wedgeCount[to] < 2)) return;
+        heap.push({ cost(from, to), from, to, version[from], version[to] });
+    };
+    for (uint32_t c = 0; c < (uint32_t)classCount; ++c) {
+        gatherNeighbours(c);
+        for (uint32_t n : neighbours) pushEdge(c, n);
+    }
+
+    double maxCost = 0.0;
+    size_t levelBase = aliveCount;
+    size_t target = (size_t)(levelBase * ratio);
+
+    auto snapshot = [&]() {
+        LodLevel level;
+        level.indices.reserve(aliveCount * 3);
+        for (size_t t = 0; t < triCount; ++t)
+            if (alive[t]) level.indices.insert(level.indices.end(), &tris[t * 3], &tris[t * 3] + 3);
+        level.error = (float)std::sqrt(maxCost);
+        levels.push_back(std::move(level));
+    };
+
+    while ((int)levels.size() < maxLevels) {
+        bool progressed = false;
+        while (aliveCount > target && !heap.empty()) {
+            Collapse e = heap.top();
+            heap.pop();
+            if (dead[e.from] || dead[e.to] || e.fromVersion != version[e.from] || e.toVersion != version[e.to])
+                continue;
+            if (flips(e.from, e.to) || !buildRemap(e.from, e.to))
+                continue;
+
+            // collapse e.from onto e.to
+            for (uint32_t t : adj[e.from]) {
+                if (!alive[t]) continue;
+                unsigned int* tri = &tris[t * 3];
+                if (cls[tri[0]] == e.to || cls[tri[1]] == e.to || cls[tri[2]] == e.to) {
+                    alive[t] = 0;
+                    --aliveCount;
+                    continue;
+                }
+                for (int k = 0; k < 3; ++k) {
+                    if (cls[tri[k]] != e.from) continue;
+                    for (auto& m : remap) if (m.first == tri[k]) { tri[k] = m.second; break; }
+                }
+                adj[e.to].push_back(t);
+            }
+            quadric[e.to].add(quadric[e.from]);
+            maxCost = std::max(maxCost, e.cost);
+            dead[e.from] = 1;
+            adj[e.from].clear();
+            adj[e.from].shrink_to_fit();
+            ++version[e.to];
+            progressed = true;
+
+            // drop dead triangles so adjacency scans stay short
+            auto& a = adj[e.to];
+            a.erase(std::remove_if(a.begin(), a.end(), [&](uint32_t t) { return !alive[t]; }), a.end());
+
+            gatherNeighbours(e.to);
+            for (uint32_t n : neighbours) {
+                pushEdge(e.to, n);
+                pushEdge(n, e.to);
+            }
+        }
+
+        // stuck above the target: keep the level only if it is a real reduction
+        if (!progressed || aliveCount * 10 > levelBase * 9) break;
+        snapshot();
+        if (aliveCount > target) break;
+        levelBase = aliveCount;
+        target = (size_t)(levelBase * ratio);
+    }
+
+    stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    if (outStats) *outStats = stats;
+    return levels;
+}
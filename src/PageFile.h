@@ -0,0 +1,162 @@
+// PageFile.h
+// Virtual texture page files ("<image>.pages" next to the source image):
+// every mip level is cut into 120x120 tiles and each tile is stored as a
+// 128x128 page, i.e. with a 4-texel border copied from its neighbours, so a
+// page filters correctly in any atlas slot. Borders wrap in U (the planet
+// maps are equirectangular) and clamp in V. Pages are BC1/BC3 blocks like
+// the .ktx bakes; the border is one block wide, so pages stay block aligned.
+// Written by tools/textureBake.cpp -p, streamed by VirtualTexture.
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "TextureFile.h"
+
+const uint32_t PAGE_FILE_VERSION = 1;
+const uint32_t PAGE_TILE_SIZE = 120;                              // content texels per side
+const uint32_t PAGE_BORDER = 4;
+const uint32_t PAGE_SIZE = PAGE_TILE_SIZE + 2 * PAGE_BORDER;      // texels per side in the file and the atlas
+const uint32_t PAGE_MAX_LEVELS = 16;
+
+const char PAGE_FILE_MAGIC[4] = { 'V', 'T', 'P', 'F' };
+
+struct PageFileHeader {
+    char     magic[4];
+    uint32_t version;
+    uint32_t internalFormat;        // KTX_COMPRESSED_RGB_S3TC_DXT1 or ..._RGBA_S3TC_DXT5
+    uint32_t width, height;         // level 0
+    uint32_t tileSize;
+    uint32_t border;
+    uint32_t levelCount;            // down to the first level that fits in one tile
+    uint32_t pageCount;
+    uint32_t pageBytes;
+};
+static_assert(sizeof(PageFileHeader) == 40, "page file header is 40 bytes");
+
+// Pages of a level are stored row by row starting at firstPage.
+struct PageLevel {
+    uint32_t width, height;
+    uint32_t tilesX, tilesY;
+    uint32_t firstPage;
+};
+
+// Header and level table of a validated file; page data is read on demand.
+struct PageFileInfo {
+    PageFileHeader header;
+    std::vector<PageLevel> levels;
+    uint64_t dataOffset = 0;
+
+    uint64_t pageOffset(uint32_t page) const { return dataOffset + (uint64_t)page * header.pageBytes; }
+};
+
+inline std::string pageFilePath(const char* imagePath) {
+    return std::string(imagePath) + ".pages";
+}
+
+inline uint32_t pageBytesFor(uint32_t internalFormat) {
+    return (PAGE_SIZE / 4) * (PAGE_SIZE / 4) * ktxBlockBytes(internalFormat);
+}
+
+// Same halving as downsampleRGBA(); the last level fits in a single tile.
+inline std::vector<PageLevel> pageLevelsFor(uint32_t width, uint32_t height) {
+    std::vector<PageLevel> levels;
+    uint32_t first = 0;
+    for (;;) {
+        PageLevel l;
+        l.width = width;
+        l.height = height;
+        l.tilesX = (width + PAGE_TILE_SIZE - 1) / PAGE_TILE_SIZE;
+        l.tilesY = (height + PAGE_TILE_SIZE - 1) / PAGE_TILE_SIZE;
+        l.firstPage = first;
+        levels.push_back(l);
+        first += l.tilesX * l.tilesY;
+        if ((l.tilesX == 1 && l.tilesY == 1) || levels.size() == PAGE_MAX_LEVELS) break;
+        width = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+    }
+    return levels;
+}
+
+// Copies tile (tx, ty) of an RGBA8 level plus its border into a PAGE_SIZE^2 page.
+inline void extractPage(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t tx, uint32_t ty, uint8_t* page) {
+    for (uint32_t y = 0; y < PAGE_SIZE; ++y) {
+        long sy = (long)(ty * PAGE_TILE_SIZE + y) - (long)PAGE_BORDER;
+        sy = std::min(std::max(sy, 0L), (long)height - 1);
+        for (uint32_t x = 0; x < PAGE_SIZE; ++x) {
+            long sx = (long)(tx * PAGE_TILE_SIZE + x) - (long)PAGE_BORDER;
+            sx = ((sx % (long)width) + (long)width) % (long)width;
+            memcpy(page + ((size_t)y * PAGE_SIZE + x) * 4, rgba + ((size_t)sy * width + sx) * 4, 4);
+        }
+    }
+}
+
+// Reads and checks the header and level table against the file size.
+inline bool readPageFileInfo(const char* path, PageFileInfo& info) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    PageFileHeader& h = info.header;
+    bool ok = fread(&h, sizeof(h), 1, f) == 1 &&
+              memcmp(h.magic, PAGE_FILE_MAGIC, 4) == 0 && h.version == PAGE_FILE_VERSION &&
+              (h.internalFormat == KTX_COMPRESSED_RGB_S3TC_DXT1 || h.internalFormat == KTX_COMPRESSED_RGBA_S3TC_DXT5) &&
+              h.tileSize == PAGE_TILE_SIZE && h.border == PAGE_BORDER && h.pageBytes == pageBytesFor(h.internalFormat) &&
+              h.width > 0 && h.height > 0 && h.levelCount > 0 && h.levelCount <= PAGE_MAX_LEVELS;
+    if (ok) {
+        info.levels.resize(h.levelCount);
+        ok = fread(info.levels.data(), sizeof(PageLevel), h.levelCount, f) == h.levelCount;
+    }
+    if (ok) {
+        // the table must be exactly what the baker derives from the size
+        std::vector<PageLevel> expected = pageLevelsFor(h.width, h.height);
+        const PageLevel& last = expected.back();
+        ok = expected.size() == h.levelCount &&
+             memcmp(expected.data(), info.levels.data(), sizeof(PageLevel) * h.levelCount) == 0 &&
+             last.firstPage + last.tilesX * last.tilesY == h.pageCount;
+    }
+    if (ok) {
+        info.dataOffset = sizeof(PageFileHeader) + sizeof(PageLevel) * h.levelCount;
+        ok = fseek(f, 0, SEEK_END) == 0 && (uint64_t)ftell(f) >= info.pageOffset(h.pageCount);
+    }
+    fclose(f);
+    if (!ok) info.levels.clear();
+    return ok;
+}
+
+// Writes atomically (temp file + rename). pages[i] holds level i's pages back to back.
+inline bool writePageFile(const char* path, uint32_t internalFormat, uint32_t width, uint32_t height,
+                          const std::vector<std::vector<uint8_t>>& pages) {
+    std::vector<PageLevel> levels = pageLevelsFor(width, height);
+    if (pages.size() != levels.size()) return false;
+
+    PageFileHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, PAGE_FILE_MAGIC, 4);
+    h.version = PAGE_FILE_VERSION;
+    h.internalFormat = internalFormat;
+    h.width = width;
+    h.height = height;
+    h.tileSize = PAGE_TILE_SIZE;
+    h.border = PAGE_BORDER;
+    h.levelCount = (uint32_t)levels.size();
+    h.pageCount = levels.back().firstPage + levels.back().tilesX * levels.back().tilesY;
+    h.pageBytes = pageBytesFor(internalFormat);
+
+    std::string tmp = std::string(path) + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "wb");
+    if (!f) return false;
+    bool ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+              fwrite(levels.data(), sizeof(PageLevel), levels.size(), f) == levels.size();
+    for (size_t i = 0; ok && i < levels.size(); ++i)
+        ok = pages[i].size() == (size_t)levels[i].tilesX * levels[i].tilesY * h.pageBytes &&
+             fwrite(pages[i].data(), 1, pages[i].size(), f) == pages[i].size();
+    ok = (fclose(f) == 0) && ok;
+    if (ok) {
+        remove(path); // rename() does not replace on Windows
+        ok = rename(tmp.c_str(), path) == 0;
+    }
+    if (!ok) remove(tmp.c_str());
+    return ok;
+}
@@ -0,0 +1,258 @@
+// SceneGraph.h
+#pragma once
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "Frustum.h"
+#include "JobSystem.h"
+
+// Transform hierarchy in flat arrays instead of heap nodes: local and world
+// matrices are contiguous and ordered by depth, parents are indices, and
+// update() computes world matrices in one linear pass (a parent always comes
+// before its children). World matrices are cached: setLocal() with a new
+// matrix marks the node dirty, and update() recomputes only dirty nodes and
+// the subtrees below them, so static subtrees are not multiplied again and a
+// frame where nothing moved costs nothing. Rendering is a separate pass over a flat draw
+// list of (tag, node) items; the tag tells the caller what to draw, and
+// nodes with bounds can be culled against a view's frustum.
+// Node ids stay valid when the arrays are reordered.
+class SceneGraph {
+public:
+    typedef uint32_t NodeId;
+    static constexpr NodeId NONE = 0xffffffffu;
+
+    // New node with an identity transform under 'parent' (NONE for a root).
+    NodeId create(NodeId parent = NONE) {
+        uint32_t parentSlot = (parent == NONE) ? NONE : slots[parent];
+        uint32_t depth = (parentSlot == NONE) ? 0 : depths[parentSlot] + 1;
+        if (!depths.empty() && depth < depths.back())
+            sorted = false;   // still parent-first, just no longer grouped by depth
+
+        NodeId id = (NodeId)slots.size();
+        slots.push_back((uint32_t)locals.size());
+        nodes.push_back(id);
+        locals.push_back(glm::mat4(1.0f));
+        worlds.push_back(glm::mat4(1.0f));
+        parents.push_back(parentSlot);
+        depths.push_back(depth);
+        dirty.push_back(1);
+        changedAt.push_back(0);
+        localBounds.push_back(BoundingSphere());
+        worldBounds.push_back(BoundingSphere());
+        anyDirty = true;
+        levelsValid = false;
+        return id;
+    }
+
+    // Setting the same matrix again does not dirty the node, so callers can
+    // rebuild locals every frame and still get the static-subtree savings.
+    void setLocal(NodeId node, const glm::mat4& m) {
+        uint32_t s = slots[node];
+        if (locals[s] == m) return;
+        locals[s] = m;
+        dirty[s] = 1;
+        anyDirty = true;
+    }
+    const glm::mat4& local(NodeId node) const { return locals[slots[node]]; }
+    // As of the last update().
+    const glm::mat4& world(NodeId node) const { return worlds[slots[node]]; }
+    // Bounding sphere of what the node draws, in its local space (e.g. the
+    // mesh's). Nodes without one are never culled.
+    void setBounds(NodeId node, const glm::vec3& center, float radius) {
+        uint32_t s = slots[node];
+        localBounds[s].center = center;
+        localBounds[s].radius = radius;
+        dirty[s] = 1;
+        anyDirty = true;
+    }
+    // setBounds() under world(), as of the last update().
+    const BoundingSphere& bounds(NodeId node) const { return worldBounds[slots[node]]; }
+
+    // True if the last update() changed the node's world matrix.
+    bool changed(NodeId node) const { return changedAt[slots[node]] == stamp; }
+
+    NodeId parent(NodeId node) const {
+        uint32_t p = parents[slots[node]];
+        return (p == NONE) ? NONE : nodes[p];
+    }
+
+    // Puts 'node' on the draw list under 'tag'.
+    void addDraw(NodeId node, uint32_t tag) {
+        draws.push_back({ tag, slots[node] });
+        drawsSorted = false;
+    }
+
+    // Once per frame, before the worlds are read. world = parent's world *
+    // local for every dirty node and every node whose parent changed in this
+    // update; returns immediately when nothing was dirtied. Regroups the
+    // arrays by depth first if nodes were added out of order.
+    void update() {
+        if (!beginUpdate()) return;
+        updated = updateRange(0, locals.size());
+        anyDirty = false;
+    }
+
+    // Same, spread over 'jobs': the nodes of one depth level only read the
+    // level above, so each level is split into chunks of 'grain' nodes and
+    // levels run one after another. Small scenes stay on the calling thread.
+    void update(JobSystem& jobs, size_t grain = 4096) {
+        if (!beginUpdate()) return;
+        if (locals.size() <= grain) {
+            updated = updateRange(0, locals.size());
+        } else {
+            if (!levelsValid) findLevels();
+            std::atomic<size_t> count{0};
+            for (size_t l = 0; l + 1 < levelStart.size(); ++l) {
+                size_t first = levelStart[l];
+                jobs.parallelFor(levelStart[l + 1] - first, grain, [&](size_t begin, size_t end) {
+                    count.fetch_add(updateRange(first + begin, first + end));
+                });
+            }
+            updated = count.load();
+        }
+        anyDirty = false;
+    }
+
+    // Render pass: f(tag, world) for every draw item, grouped by tag and in
+    // array order within a tag. Uses the worlds of the last update().
+    template <class F>
+    void forEachDraw(F&& f) const {
+        for (const DrawItem& d : draws)
+            f(d.tag, worlds[d.slot]);
+    }
+
+    // As forEachDraw(), skipping items whose bounds miss 'frustum'; 'stats'
+    // (if given) counts both.
+    template <class F>
+    void forEachVisible(const Frustum& frustum, CullStats* stats, F&& f) const {
+        for (const DrawItem& d : draws) {
+            bool visible = frustum.intersects(worldBounds[d.slot]);
+            if (stats) stats->count(visible);
+            if (visible) f(d.tag, worlds[d.slot]);
+        }
+    }
+
+    size_t size() const { return locals.size(); }
+    size_t drawCount() const { return draws.size(); }
+    // World matrices recomputed by the last update().
+    size_t updatedCount() const { return updated; }
+
+private:
+    struct DrawItem {
+        uint32_t tag;
+        uint32_t slot;
+    };
+
+    // Sorts and stamps the update; false if no world can change.
+    bool beginUpdate() {
+        if (!sorted) sortByDepth();
+        if (!drawsSorted) sortDraws();
+        ++stamp;
+        updated = 0;
+        return anyDirty;
+    }
+
+    // Recomputes the dirty slots of [begin, end) and those whose parent
+    // changed in this update; returns how many.
+    size_t updateRange(size_t begin, size_t end) {
+        size_t count = 0;
+        for (size_t i = begin; i < end; ++i) {
+            uint32_t p = parents[i];
+            bool parentChanged = (p != NONE) && changedAt[p] == stamp;
+            if (!dirty[i] && !parentChanged) continue;
+            worlds[i] = (p == NONE) ? locals[i] : worlds[p] * locals[i];
+            worldBounds[i] = BoundingSphere::transformed(localBounds[i].center, localBounds[i].radius, worlds[i]);
+            changedAt[i] = stamp;
+            dirty[i] = 0;
+            ++count;
+        }
+        return count;
+    }
+
+    // levelStart[d] = first slot of depth d, plus one past the end.
+    void findLevels() {
+        levelStart.clear();
+        for (size_t i = 0; i < depths.size(); ++i)
+            while (levelStart.size() <= depths[i])
+                levelStart.push_back((uint32_t)i);
+        levelStart.push_back((uint32_t)depths.size());
+        levelsValid = true;
+    }
+
+    // Stable counting sort of the slots by depth; parents keep preceding
+    // their children because they are one level up.
+    void sortByDepth() {
+        const size_t n = locals.size();
+        uint32_t maxDepth = 0;
+        for (uint32_t d : depths) maxDepth = std::max(maxDepth, d);
+        std::vector<uint32_t> start(maxDepth + 2, 0);
+        for (uint32_t d : depths) ++start[d + 1];
+        for (size_t d = 1; d < start.size(); ++d) start[d] += start[d - 1];
+
+        std::vector<uint32_t> remap(n);   // old slot -> new slot
+        for (size_t i = 0; i < n; ++i) remap[i] = start[depths[i]]++;
+
+        std::vector<glm::mat4> newLocals(n), newWorlds(n);
+        std::vector<uint32_t> newParents(n), newDepths(n), newChangedAt(n);
+        std::vector<uint8_t> newDirty(n);
+        std::vector<BoundingSphere> newLocalBounds(n), newWorldBounds(n);
+        std::vector<NodeId> newNodes(n);
+        for (size_t i = 0; i < n; ++i) {
+            uint32_t j = remap[i];
+            newLocals[j] = locals[i];
+            newWorlds[j] = worlds[i];
+            newParents[j] = (parents[i] == NONE) ? NONE : remap[parents[i]];
+            newDepths[j] = depths[i];
+            newNodes[j] = nodes[i];
+            newDirty[j] = dirty[i];
+            newChangedAt[j] = changedAt[i];
+            newLocalBounds[j] = localBounds[i];
+            newWorldBounds[j] = worldBounds[i];
+            slots[nodes[i]] = j;
+        }
+        locals.swap(newLocals);
+        worlds.swap(newWorlds);
+        parents.swap(newParents);
+        depths.swap(newDepths);
+        nodes.swap(newNodes);
+        dirty.swap(newDirty);
+        changedAt.swap(newChangedAt);
+        localBounds.swap(newLocalBounds);
+        worldBounds.swap(newWorldBounds);
+        for (DrawItem& d : draws) d.slot = remap[d.slot];
+        sorted = true;
+        drawsSorted = false;
+        levelsValid = false;
+    }
+
+    void sortDraws() {
+        std::sort(draws.begin(), draws.end(), [](const DrawItem& a, const DrawItem& b) {
+            return a.tag != b.tag ? a.tag < b.tag : a.slot < b.slot;
+        });
+        drawsSorted = true;
+    }
+
+    // per slot
+    std::vector<glm::mat4> locals, worlds;
+    std::vector<uint32_t> parents;      // parent slot, NONE for roots
+    std::vector<uint32_t> depths;
+    std::vector<NodeId> nodes;          // slot -> node id
+    std::vector<uint8_t> dirty;         // local set since the last update()
+    std::vector<uint32_t> changedAt;    // stamp of the update() that last changed the world
+    std::vector<BoundingSphere> localBounds, worldBounds;
+    // per node id
+    std::vector<uint32_t> slots;        // node id -> slot
+
+    std::vector<uint32_t> levelStart;   // valid when levelsValid (arrays sorted)
+
+    std::vector<DrawItem> draws;
+    bool sorted = true;
+    bool drawsSorted = true;
+    bool anyDirty = false;
+    bool levelsValid = false;
+    uint32_t stamp = 1;                 // update() count; 0 is never a current stamp
+    size_t updated = 0;
+};
@@ -0,0 +1,64 @@
+#include "ShadowCache.h"
+
+void ShadowCache::init(GLuint target, int w, int h, GLenum depthFormat) {
+    targetFBO = target;
+    width = w;
+    height = h;
+
+    // same storage as the target, so the depth blit is a plain copy
+    glGenTextures(1, &baseTexture);
+    glBindTexture(GL_TEXTURE_2D, baseTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, (GLint)depthFormat, width, height, 0,
+                 GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    GLint previousFBO = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFBO);
+    glGenFramebuffers(1, &baseFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, baseFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, baseTexture, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)previousFBO);
+    valid = false;
+}
+
+ShadowCache::Redraw ShadowCache::begin(const glm::mat4& lightMatrix, uint32_t staticKey, bool dynamicChanged) {
+    ++counters.frames;
+    Redraw redraw = NOTHING;
+    if (!valid || lightMatrix != lastLight || staticKey != lastStaticKey)
+        redraw = ALL;
+    else if (dynamicChanged)
+        redraw = DYNAMIC;
+
+    switch (redraw) {
+    case NOTHING: ++counters.skipped; break;
+    case DYNAMIC: ++counters.dynamicOnly; break;
+    case ALL:     ++counters.full; break;
+    }
+    lastLight = lightMatrix;
+    lastStaticKey = staticKey;
+    valid = true;
+    return redraw;
+}
+
+void ShadowCache::bindBase() const {
+    glBindFramebuffer(GL_FRAMEBUFFER, baseFBO);
+    glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+void ShadowCache::bindDynamic() const {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, baseFBO);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, targetFBO);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, targetFBO);
+}
+
+void ShadowCache::release() {
+    if (baseFBO) glDeleteFramebuffers(1, &baseFBO);
+    if (baseTexture) glDeleteTextures(1, &baseTexture);
+    baseFBO = baseTexture = 0;
+    valid = false;
+}
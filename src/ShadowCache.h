@@ -0,0 +1,56 @@
+// ShadowCache.h
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+
+// Keeps a shadow map across frames instead of re-rendering it from scratch.
+// Casters are split into static ones (drawn into a private base map) and
+// dynamic ones (drawn over a copy of the base map, into the map the scene
+// samples). Each frame begin() compares the light matrix and the static
+// casters' key with the last render and is told whether any dynamic caster
+// changed:
+//   nothing changed          -> NOTHING: the map is still valid, skip the pass
+//   only dynamic casters     -> DYNAMIC: copy base, draw dynamic casters
+//   light or static casters  -> ALL: redraw base, then as DYNAMIC
+class ShadowCache {
+public:
+    enum Redraw { NOTHING, DYNAMIC, ALL };
+
+    struct Stats {
+        size_t frames = 0;
+        size_t skipped = 0;         // NOTHING
+        size_t dynamicOnly = 0;     // DYNAMIC
+        size_t full = 0;            // ALL
+    };
+
+    // targetFBO has the sampled depth texture attached; the base map is
+    // created to match (width x height, depthFormat).
+    void init(GLuint targetFBO, int width, int height, GLenum depthFormat = GL_DEPTH_COMPONENT);
+
+    // Once per frame, before the pass. staticKey identifies the static
+    // caster set (e.g. whether the ground is shown).
+    Redraw begin(const glm::mat4& lightMatrix, uint32_t staticKey, bool dynamicChanged);
+
+    // ALL only: binds the base map cleared; draw the static casters.
+    void bindBase() const;
+    // DYNAMIC and ALL: copies the base map into the target, which is left
+    // bound; draw the dynamic casters.
+    void bindDynamic() const;
+
+    // Forces ALL on the next begin() (e.g. after the target was resized).
+    void invalidate() { valid = false; }
+
+    const Stats& stats() const { return counters; }
+    void release();
+
+private:
+    GLuint targetFBO = 0, baseFBO = 0, baseTexture = 0;
+    int width = 0, height = 0;
+    bool valid = false;
+    glm::mat4 lastLight = glm::mat4(1.0f);
+    uint32_t lastStaticKey = 0;
+    Stats counters;
+};
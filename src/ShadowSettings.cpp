@@ -0,0 +1,127 @@
+#include "ShadowSettings.h"
+
+namespace {
+    const ShadowTier TIERS[ShadowSettings::TIER_COUNT] = {
+        // name      cascade cube  depth format           taps1 taps2 cascade/N cube/N faces
+        { "low",     512,    256,  GL_DEPTH_COMPONENT16,  3,    3,    4,        2,     2 },
+        { "medium",  1024,   512,  GL_DEPTH_COMPONENT24,  4,    4,    2,        1,     3 },
+        { "high",    1024,   1024, GL_DEPTH_COMPONENT24,  5,    6,    1,        1,     6 },
+        { "ultra",   2048,   2048, GL_DEPTH_COMPONENT32F, 12,   10,   1,        1,     6 },
+    };
+
+    const uint64_t SETTLE_FRAMES = 60;     // after a change: reallocation, timer latency, smoothing
+    const uint64_t RETRY_FRAMES = 1200;    // a tier found too slow is not retried before
+    const float    SMOOTHING = 0.1f;
+    const float    STEP_UP = 0.6f;         // of targetMs: room enough for the next tier
+}
+
+const ShadowTier& ShadowSettings::tier(int t) {
+    return TIERS[t < 0 ? 0 : (t >= TIER_COUNT ? TIER_COUNT - 1 : t)];
+}
+
+void ShadowSettings::select(int t) {
+    automatic = false;
+    change(t);
+}
+
+void ShadowSettings::setAuto(bool on) {
+    automatic = on;
+    smoothedMs = 0.0f;
+    settleUntil = frame + SETTLE_FRAMES;
+}
+
+void ShadowSettings::cycle() {
+    if (automatic)
+        select(LOW);
+    else if (active == ULTRA)
+        setAuto(true);
+    else
+        select(active + 1);
+}
+
+void ShadowSettings::change(int t) {
+    if (t < 0 || t >= TIER_COUNT || t == active) return;
+    active = t;
+    changed = true;
+    forcedFrame = frame + 1;
+    smoothedMs = 0.0f;
+    settleUntil = frame + SETTLE_FRAMES;
+}
+
+bool ShadowSettings::cascadeDue(int cascade) const {
+    int interval = settings().cascadeInterval;
+    return cascade == 0 || interval <= 1 || frame == forcedFrame || (frame + cascade) % interval == 0;
+}
+
+unsigned ShadowSettings::cascadeMask(int cascadeCount) const {
+    unsigned mask = 0;
+    for (int c = 0; c < cascadeCount; ++c)
+        if (cascadeDue(c)) mask |= 1u << c;
+    return mask;
+}
+
+int ShadowSettings::cubeFacesDue() const {
+    const ShadowTier& t = settings();
+    if (frame == forcedFrame || (t.cubeFacesPerUpdate >= 6 && t.cubeInterval <= 1))
+        return 0x3f;
+    uint64_t interval = t.cubeInterval > 1 ? t.cubeInterval : 1;
+    if (frame % interval != 0)
+        return 0;
+    int perUpdate = t.cubeFacesPerUpdate > 0 ? t.cubeFacesPerUpdate : 1;
+    int first = (int)((frame / interval * perUpdate) % 6);
+    int mask = 0;
+    for (int i = 0; i < perUpdate && i < 6; ++i)
+        mask |= 1 << ((first + i) % 6);
+    return mask;
+}
+
+bool ShadowSettings::frameTime(float ms) {
+    if (!automatic) return false;
+    smoothedMs = (smoothedMs > 0.0f) ? smoothedMs + SMOOTHING * (ms - smoothedMs) : ms;
+    if (frame < settleUntil) return false;
+
+    if (smoothedMs > targetMs && active > LOW) {
+        blockedUntil[active] = frame + RETRY_FRAMES;
+        change(active - 1);
+        return true;
+    }
+    if (smoothedMs < STEP_UP * targetMs && active < ULTRA && frame >= blockedUntil[active + 1]) {
+        change(active + 1);
+        return true;
+    }
+    return false;
+}
+
+void GpuFrameTimer::init() {
+    glGenQueries(LATENCY, queries);
+    started = read = 0;
+}
+
+void GpuFrameTimer::begin() {
+    if (started - read == (size_t)LATENCY)
+        ++read;     // never collected: its query is reused
+    glBeginQuery(GL_TIME_ELAPSED, queries[started % LATENCY]);
+}
+
+void GpuFrameTimer::end() {
+    glEndQuery(GL_TIME_ELAPSED);
+    ++started;
+}
+
+bool GpuFrameTimer::result(float& ms) {
+    if (read == started) return false;
+    GLuint query = queries[read % LATENCY];
+    GLint available = 0;
+    glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) return false;
+    GLuint64 ns = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &ns);
+    ms = (float)(ns * 1e-6);
+    ++read;
+    return true;
+}
+
+void GpuFrameTimer::release() {
+    if (queries[0]) glDeleteQueries(LATENCY, queries);
+    for (GLuint& q : queries) q = 0;
+}
@@ -0,0 +1,95 @@
+// ShadowSettings.h
+#pragma once
+
+#include <GL/glew.h>
+#include <cstddef>
+#include <cstdint>
+
+// One shadow quality level: map sizes and depth format, PCF tap counts, and
+// how often each map is re-rendered.
+struct ShadowTier {
+    const char* name;
+    int cascadeSize;            // light 1: size of each cascade layer
+    int cubeSize;               // light 2: size of each cube face
+    GLenum depthFormat;         // both lights: GL_DEPTH_COMPONENT16 / 24 / 32F
+    int pcfTaps1;               // light 1: depth-compare taps on a rotated Vogel disk
+    int pcfTaps2;               // light 2: the same, around the cube lookup direction
+    int cascadeInterval;        // light 1: cascades after the first re-rendered every N frames, staggered
+    int cubeInterval;           // light 2: cube re-rendered every N frames
+    int cubeFacesPerUpdate;     // light 2: faces per re-render, round robin (6 = whole cube)
+};
+
+// Runtime-switchable shadow tier, and the frame counter deciding which maps
+// are due for re-rendering. A skipped cascade keeps its last matrix and map;
+// skipped cube faces keep the depths from the light's earlier position.
+//
+// In auto mode frameTime() is fed the GPU time of each frame and moves one
+// tier down when the smoothed time stays above targetMs, or one up when it
+// stays well below. A tier that was too slow is not retried for a while, so
+// the choice does not oscillate between two neighbours.
+class ShadowSettings {
+public:
+    enum Tier { LOW, MEDIUM, HIGH, ULTRA, TIER_COUNT };
+
+    static const ShadowTier& tier(int t);
+
+    float targetMs = 1000.0f / 60.0f;   // auto mode: GPU time per frame to stay under
+
+    explicit ShadowSettings(int initial = HIGH) : active(initial) {}
+
+    const ShadowTier& settings() const { return tier(active); }
+    int current() const { return active; }
+    bool isAuto() const { return automatic; }
+
+    // Manual tier; leaves auto mode.
+    void select(int t);
+    void setAuto(bool on);
+    // LOW, MEDIUM, HIGH, ULTRA, auto, LOW, ...
+    void cycle();
+
+    // True once after the tier changed: the maps must be recreated.
+    bool takeChanged() { bool c = changed; changed = false; return c; }
+
+    // Once per frame, before the shadow passes.
+    void beginFrame() { ++frame; }
+    bool cascadeDue(int cascade) const;
+    // Bit per cascade, for CascadedShadowMap::fit().
+    unsigned cascadeMask(int cascadeCount) const;
+    // Bit per cube face (+X, -X, +Y, -Y, +Z, -Z); 0 when the cube is not due.
+    int cubeFacesDue() const;
+
+    // Auto mode: GPU milliseconds of a finished frame. Returns true when the
+    // tier was changed.
+    bool frameTime(float ms);
+
+private:
+    int active;
+    bool automatic = false;
+    bool changed = false;
+    uint64_t frame = 0;
+    uint64_t forcedFrame = 1;               // every map due (first frame, new tier)
+
+    float smoothedMs = 0.0f;
+    uint64_t settleUntil = 0;                // no decision before this frame
+    uint64_t blockedUntil[TIER_COUNT] = {};  // too slow: not stepped up into before this frame
+
+    void change(int t);
+};
+
+// GPU time of a frame's commands through GL_TIME_ELAPSED queries, read a
+// few frames late so that asking never stalls the pipeline. Frames may not
+// nest; GL thread only.
+class GpuFrameTimer {
+public:
+    void init();
+    void begin();
+    void end();
+    // Oldest finished frame, if one is ready.
+    bool result(float& ms);
+    void release();
+
+private:
+    static const int LATENCY = 4;
+    GLuint queries[LATENCY] = {};
+    size_t started = 0, read = 0;
+};
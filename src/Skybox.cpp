@@ -0,0 +1,130 @@
+#include "Skybox.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <iostream>
+
+void Skybox::init(GLuint skyProg, GLuint equirectProg) {
+    skyProgram = skyProg;
+    equirectProgram = equirectProg;
+    uInvViewProj = glGetUniformLocation(skyProgram, "invViewProj");
+    glUseProgram(skyProgram);
+    glUniform1i(glGetUniformLocation(skyProgram, "skybox"), 0);
+    glUseProgram(equirectProgram);
+    glUniform1i(glGetUniformLocation(equirectProgram, "equirect"), 0);
+    glUseProgram(0);
+
+    glGenVertexArrays(1, &vao);
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);   // filter across face edges
+}
+
+bool Skybox::buildFromEquirect(GLuint equirectTexture, int faceSize) {
+    GLint previousTexture = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &previousTexture);
+    GLint sourceWidth = 0;
+    glBindTexture(GL_TEXTURE_2D, equirectTexture);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &sourceWidth);
+    if (faceSize <= 0)
+        faceSize = std::min(sourceWidth / 4, maxFaceSize);
+    if (faceSize <= 0) {
+        glBindTexture(GL_TEXTURE_2D, (GLuint)previousTexture);
+        return false;
+    }
+
+    if (cubemap) glDeleteTextures(1, &cubemap);
+    glGenTextures(1, &cubemap);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap);
+    for (int i = 0; i < 6; ++i)
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA8, faceSize, faceSize, 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+    GLint previousFBO = 0, previousProgram = 0, viewport[4];
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFBO);
+    glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST), cull = glIsEnabled(GL_CULL_FACE);
+
+    GLuint fbo = 0;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, faceSize, faceSize);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+    glUseProgram(equirectProgram);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, equirectTexture);
+    glBindVertexArray(vao);
+
+    // GL cube face layout: direction = s * sAxis + t * tAxis + major, with
+    // s, t in [-1, 1] along the face's rows and columns
+    const glm::mat3 faces[6] = {
+        glm::mat3(glm::vec3( 0, 0,-1), glm::vec3(0,-1, 0), glm::vec3( 1, 0, 0)),   // +X
+        glm::mat3(glm::vec3( 0, 0, 1), glm::vec3(0,-1, 0), glm::vec3(-1, 0, 0)),   // -X
+        glm::mat3(glm::vec3( 1, 0, 0), glm::vec3(0, 0, 1), glm::vec3( 0, 1, 0)),   // +Y
+        glm::mat3(glm::vec3( 1, 0, 0), glm::vec3(0, 0,-1), glm::vec3( 0,-1, 0)),   // -Y
+        glm::mat3(glm::vec3( 1, 0, 0), glm::vec3(0,-1, 0), glm::vec3( 0, 0, 1)),   // +Z
+        glm::mat3(glm::vec3(-1, 0, 0), glm::vec3(0,-1, 0), glm::vec3( 0, 0,-1)),   // -Z
+    };
+    GLint uFace = glGetUniformLocation(equirectProgram, "face");
+    bool complete = true;
+    for (int i = 0; i < 6 && complete; ++i) {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, cubemap, 0);
+        complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        if (!complete) break;
+        glUniformMatrix3fv(uFace, 1, GL_FALSE, glm::value_ptr(faces[i]));
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+
+    glBindVertexArray(0);
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)previousFBO);
+    glDeleteFramebuffers(1, &fbo);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glUseProgram((GLuint)previousProgram);
+    if (depthTest) glEnable(GL_DEPTH_TEST);
+    if (cull) glEnable(GL_CULL_FACE);
+    glBindTexture(GL_TEXTURE_2D, (GLuint)previousTexture);
+
+    if (!complete) {
+        std::cerr << "Skybox framebuffer incomplete" << std::endl;
+        glDeleteTextures(1, &cubemap);
+        cubemap = 0;
+        return false;
+    }
+    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap);
+    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+    std::cout << "Built skybox cubemap: 6 x " << faceSize << "x" << faceSize << ", "
+              << (size_t)faceSize * faceSize * 4 * 6 * 4 / 3 / 1024 << " KB with mips" << std::endl;
+    return true;
+}
+
+void Skybox::draw(const glm::mat4& view, const glm::mat4& projection) const {
+    if (!cubemap) return;
+    // rotation only: the sky stays at infinity
+    glm::mat4 invViewProj = glm::inverse(projection * glm::mat4(glm::mat3(view)));
+
+    glUseProgram(skyProgram);
+    glUniformMatrix4fv(uInvViewProj, 1, GL_FALSE, glm::value_ptr(invViewProj));
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap);
+
+    // the cleared depth is exactly 1.0, so far-plane fragments need LEQUAL
+    glDepthFunc(GL_LEQUAL);
+    glDepthMask(GL_FALSE);
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    glDepthMask(GL_TRUE);
+    glDepthFunc(GL_LESS);
+}
+
+void Skybox::release() {
+    if (cubemap) glDeleteTextures(1, &cubemap);
+    if (vao) glDeleteVertexArrays(1, &vao);
+    cubemap = vao = 0;
+}
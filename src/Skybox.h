@@ -0,0 +1,37 @@
+// Skybox.h
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// Galaxy background as a cubemap, drawn with one full-screen triangle after
+// the opaque geometry at depth = far, so early-Z skips every pixel the scene
+// already covers. The cubemap is rendered once from an equirectangular
+// texture (the old galaxy sphere's UV mapping), after which the source can
+// be released.
+class Skybox {
+public:
+    // Face edge when buildFromEquirect() picks the size: a quarter of the
+    // source width (same texels per degree at the equator), at most this.
+    int maxFaceSize = 2048;
+
+    // Programs built from shaders/skybox_vertex.glsl with skybox_fragment.glsl
+    // and equirectToCube_fragment.glsl. Requires a current GL context.
+    void init(GLuint skyProgram, GLuint equirectProgram);
+
+    // Renders the six faces from an uploaded equirectangular texture and
+    // builds their mips. Restores framebuffer, viewport and program.
+    bool buildFromEquirect(GLuint equirectTexture, int faceSize = 0);
+    bool ready() const { return cubemap != 0; }
+
+    // Call with the scene's depth buffer bound, after opaque geometry.
+    void draw(const glm::mat4& view, const glm::mat4& projection) const;
+
+    void release();
+
+private:
+    GLuint skyProgram = 0, equirectProgram = 0;
+    GLint  uInvViewProj = -1;
+    GLuint vao = 0;         // empty: the triangle comes from gl_VertexID
+    GLuint cubemap = 0;
+};
@@ -0,0 +1,248 @@
+#include "SphereRenderer.h"
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+
+void SphereRenderer::init(const MeshCache& cache, const MeshHandle& mesh, GLuint copyProg, int layerCount,
+                          std::initializer_list<GLuint> drawPrograms) {
+    sphere = mesh;
+    copyProgram = copyProg;
+    layers = std::max(layerCount, 1);
+    GLint previousProgram = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+    glUseProgram(copyProgram);
+    glUniform1i(glGetUniformLocation(copyProgram, "source"), 0);
+
+    // sampler units are fixed once: a sampler2DArray left on unit 0 next to
+    // texture1 would make every draw of the program fail
+    programUniforms.clear();
+    for (GLuint program : drawPrograms) {
+        programUniforms.push_back({ program, glGetUniformLocation(program, "instanced") });
+        GLint bodyTextures = glGetUniformLocation(program, "bodyTextures");
+        if (bodyTextures >= 0) {
+            glUseProgram(program);
+            glUniform1i(bodyTextures, (GLint)textureUnit);
+        }
+    }
+    glUseProgram((GLuint)previousProgram);
+
+    // the instance stream advances once per instance; its pointers are set per batch
+    colorVAO = cache.createVAO(false);
+    depthVAO = cache.createVAO(true);
+    glGenBuffers(1, &instanceVBO);
+    for (GLuint vao : { colorVAO, depthVAO }) {
+        glBindVertexArray(vao);
+        GLuint last = (vao == colorVAO) ? ATTRIB_INSTANCE_LAYER_FLAGS : ATTRIB_INSTANCE_MODEL + 3;
+        for (GLuint a = ATTRIB_INSTANCE_MODEL; a <= last; ++a) {
+            glEnableVertexAttribArray(a);
+            glVertexAttribDivisor(a, 1);
+        }
+    }
+    glBindVertexArray(0);
+    glGenVertexArrays(1, &copyVAO);
+
+    glGenTextures(1, &textureArray);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, layerWidth, layerHeight, layers, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);      // the OBJ loaders negate V
+
+    // grey until setLayer(), as the loader's placeholders
+    GLint previousFBO = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFBO);
+    GLuint fbo = 0;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    const GLfloat grey[4] = { 0.5f, 0.5f, 0.5f, 1.0f };
+    for (int i = 0; i < layers; ++i) {
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, textureArray, 0, i);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE)
+            glClearBufferfv(GL_COLOR, 0, grey);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)previousFBO);
+    glDeleteFramebuffers(1, &fbo);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    std::cout << "Sphere texture array: " << layers << " x " << layerWidth << "x" << layerHeight << ", "
+              << (size_t)layerWidth * layerHeight * 4 * layers * 4 / 3 / 1024 << " KB with mips" << std::endl;
+}
+
+bool SphereRenderer::setLayer(int layer, GLuint texture) {
+    if (!textureArray || layer < 0 || layer >= layers || !texture) return false;
+
+    GLint previousFBO = 0, previousProgram = 0, previousTexture = 0, viewport[4];
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFBO);
+    glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glActiveTexture(GL_TEXTURE0);
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &previousTexture);
+    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST), cull = glIsEnabled(GL_CULL_FACE);
+
+    GLuint fbo = 0;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, textureArray, 0, layer);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (complete) {
+        // a draw rather than a blit: BC1/BC3 sources cannot be blitted or copied into RGBA8
+        glViewport(0, 0, layerWidth, layerHeight);
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_CULL_FACE);
+        glUseProgram(copyProgram);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glBindVertexArray(copyVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(0);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)previousFBO);
+    glDeleteFramebuffers(1, &fbo);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glUseProgram((GLuint)previousProgram);
+    if (depthTest) glEnable(GL_DEPTH_TEST);
+    if (cull) glEnable(GL_CULL_FACE);
+    glBindTexture(GL_TEXTURE_2D, (GLuint)previousTexture);
+
+    if (!complete) {
+        std::cerr << "Sphere texture array framebuffer incomplete" << std::endl;
+        return false;
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    return true;
+}
+
+void SphereRenderer::build(const LodView& view, int passCount, const Frustum* frustums, CullStats* stats) {
+    const size_t n = instances.size();
+    lods.resize(n);
+    visible.resize(n);
+    for (size_t i = 0; i < n; ++i)
+        lods[i] = sphere.selectLod(instances[i].model, view);
+
+    sorted.clear();
+    const size_t builtBefore = passKeys.size();
+    passes.resize(std::max(passCount, 1));
+    passKeys.resize(passes.size(), 0);
+    passChanged.resize(passes.size());
+    for (size_t pass = 0; pass < passes.size(); ++pass) {
+        uint32_t required = pass ? (uint32_t)CASTS_SHADOWS : 0u;
+        uint32_t excluded = pass ? 0u : (uint32_t)SHADOW_ONLY;
+        for (size_t i = 0; i < n; ++i) {
+            uint32_t flags = instances[i].flags;
+            bool inPass = (flags & required) == required && !(flags & excluded);
+            if (inPass && frustums) {
+                inPass = frustums[pass].intersects(sphere.worldBounds(instances[i].model));
+                if (stats) stats[pass].count(inPass);
+            }
+            visible[i] = inPass;
+        }
+        passes[pass].clear();
+        appendBatches(passes[pass]);
+
+        uint64_t key = passKey(passes[pass]);
+        passChanged[pass] = pass >= builtBefore || key != passKeys[pass];
+        passKeys[pass] = key;
+    }
+}
+
+// FNV-1a over the pass's batches and the instances they draw.
+uint64_t SphereRenderer::passKey(const std::vector<Batch>& batches) const {
+    uint64_t h = 14695981039346656037ull;
+    auto mix = [&h](const void* data, size_t size) {
+        const unsigned char* p = (const unsigned char*)data;
+        for (size_t i = 0; i < size; ++i)
+            h = (h ^ p[i]) * 1099511628211ull;
+    };
+    for (const Batch& b : batches) {
+        mix(&b.lod, sizeof(b.lod));
+        mix(&b.count, sizeof(b.count));
+        mix(&sorted[b.first], b.count * sizeof(SphereInstance));
+    }
+    return h;
+}
+
+void SphereRenderer::upload() {
+    if (sorted.empty() || !instanceVBO) return;
+
+    // orphan and refill: last frame's draws may still be reading the old storage
+    capacity = std::max(sorted.size(), capacity);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(SphereInstance), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sorted.size() * sizeof(SphereInstance), sorted.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Copies the visible instances to the end of 'sorted', grouped by LOD, one
+// batch per group.
+void SphereRenderer::appendBatches(std::vector<Batch>& batches) {
+    for (int lod = 0; lod < sphere.lodCount; ++lod) {
+        size_t first = sorted.size();
+        for (size_t i = 0; i < instances.size(); ++i) {
+            if (visible[i] && lods[i] == lod)
+                sorted.push_back(instances[i]);
+        }
+        if (sorted.size() > first)
+            batches.push_back({ lod, (GLuint)first, (GLsizei)(sorted.size() - first) });
+    }
+}
+
+void SphereRenderer::draw(GLuint program) const {
+    glActiveTexture(GL_TEXTURE0 + textureUnit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray);
+    glActiveTexture(GL_TEXTURE0);
+    if (!passes.empty())
+        drawBatches(program, colorVAO, passes[0], false);
+}
+
+void SphereRenderer::drawDepth(GLuint program, int pass) const {
+    if (pass > 0 && pass < (int)passes.size())
+        drawBatches(program, depthVAO, passes[pass], true);
+}
+
+GLint SphereRenderer::instancedLocation(GLuint program) const {
+    for (const ProgramUniforms& p : programUniforms)
+        if (p.program == program) return p.instanced;
+    return glGetUniformLocation(program, "instanced");     // not given to init()
+}
+
+// GL 3.3 has no base instance, so each batch re-points the instance stream
+// at its first instance.
+void SphereRenderer::drawBatches(GLuint program, GLuint vao, const std::vector<Batch>& batches, bool depthOnly) const {
+    if (batches.empty()) return;
+    const GLint uInstanced = instancedLocation(program);
+    glUniform1i(uInstanced, 1);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    const GLsizei stride = sizeof(SphereInstance);
+    for (const Batch& b : batches) {
+        size_t base = (size_t)b.first * sizeof(SphereInstance);
+        for (GLuint c = 0; c < 4; ++c)
+            glVertexAttribPointer(ATTRIB_INSTANCE_MODEL + c, 4, GL_FLOAT, GL_FALSE, stride,
+                                  (void*)(base + offsetof(SphereInstance, model) + c * sizeof(glm::vec4)));
+        if (!depthOnly) {
+            glVertexAttribPointer(ATTRIB_INSTANCE_TINT, 4, GL_FLOAT, GL_FALSE, stride,
+                                  (void*)(base + offsetof(SphereInstance, tint)));
+            glVertexAttribIPointer(ATTRIB_INSTANCE_LAYER_FLAGS, 2, GL_UNSIGNED_INT, stride,
+                                   (void*)(base + offsetof(SphereInstance, layer)));
+        }
+        sphere.drawInstanced(b.lod, b.count);
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glUniform1i(uInstanced, 0);
+}
+
+void SphereRenderer::release() {
+    if (textureArray) glDeleteTextures(1, &textureArray);
+    if (instanceVBO) glDeleteBuffers(1, &instanceVBO);
+    if (colorVAO) glDeleteVertexArrays(1, &colorVAO);
+    if (depthVAO) glDeleteVertexArrays(1, &depthVAO);
+    if (copyVAO) glDeleteVertexArrays(1, &copyVAO);
+    textureArray = instanceVBO = colorVAO = depthVAO = copyVAO = 0;
+    capacity = 0;
+}
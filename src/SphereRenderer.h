@@ -0,0 +1,124 @@
+// SphereRenderer.h
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+#include "Frustum.h"
+#include "MeshCache.h"
+
+// Per-instance attribute slots (vertexShader.glsl): the model matrix takes
+// four consecutive locations.
+const GLuint ATTRIB_INSTANCE_MODEL = 3;         // 3..6
+const GLuint ATTRIB_INSTANCE_TINT = 7;
+const GLuint ATTRIB_INSTANCE_LAYER_FLAGS = 8;
+
+// One sphere of the frame. The struct is the per-instance vertex stream
+// (vertexShader.glsl locations 3..8), uploaded as is.
+struct SphereInstance {
+    glm::mat4 model = glm::mat4(1.0f);
+    glm::vec4 tint = glm::vec4(1.0f);   // objectColor
+    uint32_t  layer = 0;                // texture array layer, see SphereRenderer::setLayer
+    uint32_t  flags = 0;                // SphereRenderer::Flags
+};
+static_assert(sizeof(SphereInstance) == 88, "SphereInstance is the 88-byte instance stream");
+
+// Draws every sphere of a frame (sun, planets, moon, shooting star) with
+// instanced draws instead of one draw per body: transform, tint, texture
+// layer and shading flags come from an instance buffer and the body maps
+// share one 2D texture array, so no state changes between spheres. Each pass
+// issues one glDrawElementsInstanced per sphere LOD in use, over the spheres
+// inside its frustum.
+class SphereRenderer {
+public:
+    enum Flags : uint32_t {
+        LIT              = 1u << 0,
+        TEXTURED         = 1u << 1,
+        RECEIVES_SHADOWS = 1u << 2,
+        CASTS_SHADOWS    = 1u << 3,
+        SHADOW_ONLY      = 1u << 4,   // depth passes only; the colour pass draws the body itself
+    };
+
+    // Texture array layer size, fixed by init(): the body maps are 2048x1024.
+    int layerWidth = 2048, layerHeight = 1024;
+    // Unit draw() binds the texture array to.
+    GLuint textureUnit = 5;
+
+    // After the sphere is loaded. copyProgram is skybox_vertex.glsl with
+    // textureCopy_fragment.glsl. Layers start grey, like loader placeholders.
+    // drawPrograms are the programs later given to draw() and drawDepth():
+    // their uniform locations are looked up here, and a bodyTextures sampler
+    // is pointed at textureUnit.
+    void init(const MeshCache& cache, const MeshHandle& sphere, GLuint copyProgram, int layerCount,
+              std::initializer_list<GLuint> drawPrograms);
+
+    // Resamples an uploaded 2D texture into a layer and rebuilds the array's
+    // mips. Restores framebuffer, viewport and program.
+    bool setLayer(int layer, GLuint texture);
+
+    // Per frame: clear(), add() every sphere, then upload() once before the
+    // first pass. LODs are picked per instance from the view.
+    void clear() { instances.clear(); }
+    void add(const SphereInstance& instance) { instances.push_back(instance); }
+    void upload(const LodView& view) { build(view); upload(); }
+    // upload(view) in two steps: build() picks LODs and sorts the batches
+    // without GL calls (any thread, e.g. a frame graph task), upload() then
+    // fills the instance buffer on the GL thread.
+    // Pass 0 is the colour pass, passes 1.. are depth passes. With frustums,
+    // pass i keeps only the spheres intersecting frustums[i], and stats[i]
+    // (if given) counts the drawn and culled ones.
+    void build(const LodView& view, int passCount = 2, const Frustum* frustums = nullptr,
+               CullStats* stats = nullptr);
+    void upload();
+
+    // Colour pass (pass 0) with a fragmentShader.glsl program current: binds
+    // the texture array and draws all but SHADOW_ONLY spheres.
+    void draw(GLuint program) const;
+    // Depth pass 'pass' (shadow_vertex / pointShadow_vertex programs): the
+    // CASTS_SHADOWS spheres, position stream only.
+    void drawDepth(GLuint program, int pass = 1) const;
+
+    // Last build(): instances, and instanced draws issued by a pass.
+    size_t instanceCount() const { return instances.size(); }
+    size_t drawCount(int pass) const { return pass < (int)passes.size() ? passes[pass].size() : 0; }
+    // True if the pass draws other spheres, transforms or LODs than at the
+    // build() before (always after the first), e.g. to keep a cached shadow map.
+    bool changed(int pass) const { return pass < (int)passes.size() && passChanged[pass]; }
+
+    void release();
+
+private:
+    // Instances [first, first + count) of the uploaded buffer share a LOD.
+    struct Batch {
+        int     lod;
+        GLuint  first;
+        GLsizei count;
+    };
+    void appendBatches(std::vector<Batch>& batches);
+    uint64_t passKey(const std::vector<Batch>& batches) const;
+    void drawBatches(GLuint program, GLuint vao, const std::vector<Batch>& batches, bool depthOnly) const;
+
+    // "instanced" of each draw program, from init()
+    struct ProgramUniforms {
+        GLuint program;
+        GLint  instanced;
+    };
+    std::vector<ProgramUniforms> programUniforms;
+    GLint instancedLocation(GLuint program) const;
+
+    MeshHandle sphere;
+    GLuint colorVAO = 0, depthVAO = 0, instanceVBO = 0;
+    GLuint textureArray = 0, copyProgram = 0, copyVAO = 0;
+    int layers = 0;
+    size_t capacity = 0;    // instance buffer size, in instances
+
+    std::vector<SphereInstance> instances;
+    std::vector<int> lods;                  // per instance, from build()
+    std::vector<uint8_t> visible;           // per instance, in the pass being built
+    std::vector<SphereInstance> sorted;     // the batches of every pass, in pass order
+    std::vector<std::vector<Batch>> passes;
+    std::vector<uint64_t> passKeys;         // per pass, from build()
+    std::vector<uint8_t> passChanged;
+};
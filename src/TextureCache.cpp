@@ -0,0 +1,96 @@
+#include "TextureCache.h"
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <utility>
+
+TextureHandle::TextureHandle(TextureCache* cache, TextureHandle::Entry* entry) : cache(cache), entry(entry) {
+    ++entry->refs;
+}
+
+TextureHandle::TextureHandle(const TextureHandle& other) : cache(other.cache), entry(other.entry) {
+    if (entry) ++entry->refs;
+}
+
+TextureHandle::TextureHandle(TextureHandle&& other) noexcept : cache(other.cache), entry(other.entry) {
+    other.cache = nullptr;
+    other.entry = nullptr;
+}
+
+TextureHandle& TextureHandle::operator=(TextureHandle other) noexcept {
+    std::swap(cache, other.cache);
+    std::swap(entry, other.entry);
+    return *this;
+}
+
+GLuint TextureHandle::id() const {
+    return entry ? entry->texture : 0;
+}
+
+void TextureHandle::reset() {
+    if (entry && --entry->refs == 0)
+        cache->drop(entry);
+    cache = nullptr;
+    entry = nullptr;
+}
+
+TextureHandle TextureCache::acquire(const char* path, const TextureSampler& sampler) {
+    char samplerKey[48];
+    snprintf(samplerKey, sizeof(samplerKey), "|%x,%x,%x,%x", sampler.wrapS, sampler.wrapT,
+             sampler.minFilter, sampler.magFilter);
+    std::string key = std::string(path) + samplerKey;
+
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        ++hits;
+        return TextureHandle(this, &it->second);
+    }
+    ++misses;
+    TextureHandle::Entry& entry = entries[key];
+    entry.key = key;
+    entry.texture = loader.request(path, sampler);
+    return TextureHandle(this, &entry);
+}
+
+void TextureCache::drop(TextureHandle::Entry* entry) {
+    if (entry->texture) {
+        loader.discard(entry->texture);
+        glDeleteTextures(1, &entry->texture);
+        ++freed;
+    }
+    auto it = entries.find(entry->key);
+    if (it != entries.end() && &it->second == entry) {
+        entries.erase(it);
+        return;
+    }
+    released.erase(std::remove_if(released.begin(), released.end(),
+                                  [entry](const auto& node) { return &node.mapped() == entry; }),
+                   released.end());
+}
+
+TextureCache::Stats TextureCache::stats() const {
+    Stats s;
+    for (const auto& kv : entries) {
+        if (!kv.second.texture) continue;
+        ++s.textures;
+        s.bytesResident += loader.residentBytes(kv.second.texture);
+    }
+    s.hits = hits;
+    s.misses = misses;
+    s.freed = freed;
+    return s;
+}
+
+void TextureCache::release() {
+    for (auto it = entries.begin(); it != entries.end();) {
+        TextureHandle::Entry& entry = it->second;
+        if (entry.texture) {
+            loader.discard(entry.texture);
+            glDeleteTextures(1, &entry.texture);
+            entry.texture = 0;
+        }
+        auto next = std::next(it);
+        released.push_back(entries.extract(it));    // still referenced: drop() lets it go
+        it = next;
+    }
+}
@@ -0,0 +1,82 @@
+// TextureCache.h
+#pragma once
+
+#include <GL/glew.h>
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "TextureLoader.h"
+
+class TextureCache;
+
+// Counted reference to a cached texture. Copies share the texture; when the
+// last handle goes away the cache deletes it. GL thread only, and the cache
+// must outlive its handles.
+class TextureHandle {
+public:
+    TextureHandle() = default;
+    TextureHandle(const TextureHandle& other);
+    TextureHandle(TextureHandle&& other) noexcept;
+    TextureHandle& operator=(TextureHandle other) noexcept;
+    ~TextureHandle() { reset(); }
+
+    // GL name (the loader's placeholder until the image is uploaded); 0 when empty.
+    GLuint id() const;
+    explicit operator bool() const { return entry != nullptr; }
+
+    void reset();
+
+private:
+    friend class TextureCache;
+    struct Entry;
+    TextureHandle(TextureCache* cache, Entry* entry);
+
+    TextureCache* cache = nullptr;
+    Entry* entry = nullptr;
+};
+
+struct TextureHandle::Entry {
+    std::string key;
+    GLuint texture = 0;
+    size_t refs = 0;
+};
+
+// Interns textures by path and sampler state on top of a TextureLoader: a
+// second acquire() of the same key, even while the first is still decoding,
+// shares the texture instead of decoding and uploading the file again.
+class TextureCache {
+public:
+    explicit TextureCache(TextureLoader& loader) : loader(loader) {}
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    // GL thread only. Never fails: a missing file stays a grey placeholder,
+    // as with TextureLoader::request().
+    TextureHandle acquire(const char* path, const TextureSampler& sampler = TextureSampler());
+
+    struct Stats {
+        size_t textures = 0;        // live entries
+        size_t bytesResident = 0;   // GPU bytes of their mip chains (see TextureLoader::residentBytes)
+        size_t hits = 0;            // acquire() served from the cache
+        size_t misses = 0;          // acquire() that started a load
+        size_t freed = 0;           // textures deleted after their last release
+    };
+    Stats stats() const;
+
+    // Deletes every GL texture now; call while the context is still current.
+    // Handles still alive afterwards report id() 0 and are dropped quietly;
+    // their keys are forgotten, so a later acquire() loads them again.
+    void release();
+
+private:
+    friend class TextureHandle;
+    void drop(TextureHandle::Entry* entry);
+
+    TextureLoader& loader;
+    std::unordered_map<std::string, TextureHandle::Entry> entries;
+    // Entries release() took out of the map while handles still pointed at
+    // them; extracted nodes keep their address.
+    std::vector<std::unordered_map<std::string, TextureHandle::Entry>::node_type> released;
+    size_t hits = 0, misses = 0, freed = 0;
+};
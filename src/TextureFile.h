@@ -0,0 +1,162 @@
+// TextureFile.h
+// Baked textures: KTX 1.1 files ("<image>.ktx" next to the source image)
+// holding a full pre-filtered mip chain in BC1 (RGB) or BC3 (RGBA).
+// Written by tools/textureBake.cpp, read by TextureLoader.
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include "MappedFile.h"
+
+// GL enums, duplicated so this header does not need a GL context or GLEW.
+const uint32_t KTX_COMPRESSED_RGB_S3TC_DXT1 = 0x83F0;
+const uint32_t KTX_COMPRESSED_RGBA_S3TC_DXT5 = 0x83F3;
+const uint32_t KTX_BASE_RGB = 0x1907;
+const uint32_t KTX_BASE_RGBA = 0x1908;
+
+const uint8_t KTX_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+struct KtxHeader {
+    uint8_t  identifier[12];
+    uint32_t endianness;            // 0x04030201 when written on a little-endian host
+    uint32_t glType;                // 0 for compressed data
+    uint32_t glTypeSize;
+    uint32_t glFormat;              // 0 for compressed data
+    uint32_t glInternalFormat;
+    uint32_t glBaseInternalFormat;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t numberOfArrayElements;
+    uint32_t numberOfFaces;
+    uint32_t numberOfMipmapLevels;
+    uint32_t bytesOfKeyValueData;
+};
+static_assert(sizeof(KtxHeader) == 64, "KTX header is 64 bytes");
+
+struct KtxLevel {
+    const uint8_t* data = nullptr;
+    uint32_t size = 0;
+    uint32_t width = 0, height = 0;
+};
+
+// A validated file; level data points into the mapping.
+struct TextureFileView {
+    MappedFile file;
+    uint32_t internalFormat = 0;
+    uint32_t baseFormat = 0;
+    uint32_t width = 0, height = 0;
+    std::vector<KtxLevel> levels;
+};
+
+inline std::string bakedTexturePath(const char* imagePath) {
+    return std::string(imagePath) + ".ktx";
+}
+
+// The bake is usable unless the source image is newer (a missing source is fine).
+inline bool bakedTextureIsCurrent(const char* bakedPath, const char* imagePath) {
+    struct stat baked, source;
+    if (stat(bakedPath, &baked) != 0) return false;
+    if (stat(imagePath, &source) != 0) return true;
+    return baked.st_mtime >= source.st_mtime;
+}
+
+inline uint32_t ktxBlockBytes(uint32_t internalFormat) {
+    return internalFormat == KTX_COMPRESSED_RGB_S3TC_DXT1 ? 8u : 16u;
+}
+
+// Accepts only what the baker writes: 2D, one face, BC1/BC3, native endianness.
+inline bool openTextureFile(const char* path, TextureFileView& view) {
+    auto reject = [&view]() { view.file.close(); view.levels.clear(); return false; };
+
+    if (!view.file.open(path)) return false;
+    if (view.file.size() < sizeof(KtxHeader)) return reject();
+
+    KtxHeader h;
+    memcpy(&h, view.file.data(), sizeof(h));
+    if (memcmp(h.identifier, KTX_IDENTIFIER, 12) != 0 || h.endianness != 0x04030201u) return reject();
+    if (h.glType != 0 || h.glFormat != 0 || h.pixelDepth > 1 || h.numberOfArrayElements > 1 || h.numberOfFaces != 1)
+        return reject();
+    if (h.glInternalFormat != KTX_COMPRESSED_RGB_S3TC_DXT1 && h.glInternalFormat != KTX_COMPRESSED_RGBA_S3TC_DXT5)
+        return reject();
+    if (h.pixelWidth == 0 || h.pixelHeight == 0 || h.numberOfMipmapLevels == 0 || h.numberOfMipmapLevels > 32)
+        return reject();
+
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(view.file.data());
+    size_t offset = sizeof(KtxHeader) + h.bytesOfKeyValueData;
+    uint32_t w = h.pixelWidth, hgt = h.pixelHeight, block = ktxBlockBytes(h.glInternalFormat);
+    view.levels.clear();
+    for (uint32_t i = 0; i < h.numberOfMipmapLevels; ++i) {
+        if (offset + 4 > view.file.size()) return reject();
+        uint32_t size;
+        memcpy(&size, bytes + offset, 4);
+        offset += 4;
+        if (size != ((w + 3) / 4) * ((hgt + 3) / 4) * block || offset + size > view.file.size()) return reject();
+        KtxLevel level;
+        level.data = bytes + offset;
+        level.size = size;
+        level.width = w;
+        level.height = hgt;
+        view.levels.push_back(level);
+        offset += (size + 3) & ~3u;   // mipPadding
+        w = w > 1 ? w / 2 : 1;
+        hgt = hgt > 1 ? hgt / 2 : 1;
+    }
+
+    view.internalFormat = h.glInternalFormat;
+    view.baseFormat = h.glBaseInternalFormat;
+    view.width = h.pixelWidth;
+    view.height = h.pixelHeight;
+    return true;
+}
+
+// Writes atomically (temp file + rename). levels[0] is the full-size image.
+// Rows are stored bottom-up (stb flip), recorded as KTXorientation "S=r,T=u".
+inline bool writeTextureFile(const char* path, uint32_t internalFormat, uint32_t width, uint32_t height,
+                             const std::vector<std::vector<uint8_t>>& levels) {
+    const char key[] = "KTXorientation";
+    const char value[] = "S=r,T=u";
+    uint32_t kvSize = (uint32_t)(sizeof(key) + sizeof(value));   // both include their NUL
+    uint32_t kvPadded = (kvSize + 3) & ~3u;
+
+    KtxHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.identifier, KTX_IDENTIFIER, 12);
+    h.endianness = 0x04030201u;
+    h.glTypeSize = 1;
+    h.glInternalFormat = internalFormat;
+    h.glBaseInternalFormat = (internalFormat == KTX_COMPRESSED_RGB_S3TC_DXT1) ? KTX_BASE_RGB : KTX_BASE_RGBA;
+    h.pixelWidth = width;
+    h.pixelHeight = height;
+    h.numberOfFaces = 1;
+    h.numberOfMipmapLevels = (uint32_t)levels.size();
+    h.bytesOfKeyValueData = 4 + kvPadded;
+
+    std::string tmp = std::string(path) + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "wb");
+    if (!f) return false;
+    const uint8_t zeros[4] = { 0, 0, 0, 0 };
+    bool ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+              fwrite(&kvSize, 4, 1, f) == 1 &&
+              fwrite(key, sizeof(key), 1, f) == 1 &&
+              fwrite(value, sizeof(value), 1, f) == 1 &&
+              fwrite(zeros, 1, kvPadded - kvSize, f) == kvPadded - kvSize;
+    for (size_t i = 0; ok && i < levels.size(); ++i) {
+        uint32_t size = (uint32_t)levels[i].size();
+        uint32_t pad = ((size + 3) & ~3u) - size;
+        ok = fwrite(&size, 4, 1, f) == 1 &&
+             fwrite(levels[i].data(), 1, size, f) == size &&
+             fwrite(zeros, 1, pad, f) == pad;
+    }
+    ok = (fclose(f) == 0) && ok;
+    if (ok) {
+        remove(path); // rename() does not replace on Windows
+        ok = rename(tmp.c_str(), path) == 0;
+    }
+    if (!ok) remove(tmp.c_str());
+    return ok;
+}
@@ -0,0 +1,235 @@
+#include "TextureLoader.h"
+#include "TextureFile.h"
+#include "../stb/stb_image.h"
+#include <algorithm>
+#include <iostream>
+
+GLuint TextureLoader::request(const char* path, const TextureSampler& sampler) {
+    if (workers.empty())
+        startWorkers();
+
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, (GLint)sampler.wrapS);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, (GLint)sampler.wrapT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, (GLint)sampler.minFilter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, (GLint)sampler.magFilter);
+
+    // placeholder: a single texel is already a complete mip chain
+    const unsigned char grey[4] = { 128, 128, 128, 255 };
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, grey);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    uploadedBytes[texture] = placeholderBytes;
+
+    Job job;
+    job.texture = texture;
+    job.path = path;
+    job.tryBaked = useBaked && GLEW_EXT_texture_compression_s3tc;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job.serial = ++nextSerial;
+        queued.push_back(std::move(job));
+        ++inFlight;
+    }
+    wake.notify_one();
+    return texture;
+}
+
+void TextureLoader::startWorkers() {
+    unsigned n = threads ? threads : std::thread::hardware_concurrency();
+    n = std::min(std::max(n, 1u), 8u);
+    stopping = false;
+    startTime = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < n; ++i)
+        workers.emplace_back(&TextureLoader::workerLoop, this);
+}
+
+void TextureLoader::workerLoop() {
+    stbi_set_flip_vertically_on_load_thread(1);
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || !queued.empty(); });
+            if (stopping) return;
+            job = std::move(queued.front());
+            queued.pop_front();
+            decoding.emplace(job.serial, job.texture);
+        }
+
+        auto t0 = std::chrono::steady_clock::now();
+        if (!(job.tryBaked && readBaked(job)))
+            job.pixels = stbi_load(job.path.c_str(), &job.width, &job.height, &job.channels, 0);
+        job.decodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            decoding.erase(job.serial);
+            if (cancelled.erase(job.serial)) {
+                stbi_image_free(job.pixels);
+                --inFlight;
+            } else {
+                ready.push_back(std::move(job));
+            }
+        }
+        decoded.notify_all();
+    }
+}
+
+// Copies the mip chain out of "<image>.ktx" on the worker, so the GL thread
+// never touches the disk. False if there is no current, valid bake.
+bool TextureLoader::readBaked(Job& job) {
+    std::string bakedPath = bakedTexturePath(job.path.c_str());
+    if (!bakedTextureIsCurrent(bakedPath.c_str(), job.path.c_str()))
+        return false;
+    TextureFileView view;
+    if (!openTextureFile(bakedPath.c_str(), view)) {
+        std::cerr << "Ignoring invalid baked texture " << bakedPath << std::endl;
+        return false;
+    }
+    job.compressedFormat = view.internalFormat;
+    job.width = (int)view.width;
+    job.height = (int)view.height;
+    for (const KtxLevel& level : view.levels) {
+        job.blocks.insert(job.blocks.end(), level.data, level.data + level.size);
+        job.levelSizes.push_back(level.size);
+    }
+    return true;
+}
+
+size_t TextureLoader::poll(size_t maxUploads) {
+    std::vector<Job> done;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t n = std::min(maxUploads, ready.size());
+        done.assign(std::make_move_iterator(ready.begin()), std::make_move_iterator(ready.begin() + n));
+        ready.erase(ready.begin(), ready.begin() + n);
+    }
+    if (done.empty())
+        return 0;
+
+    GLint previous = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous);
+    for (Job& job : done)
+        upload(job);
+    glBindTexture(GL_TEXTURE_2D, (GLuint)previous);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        inFlight -= done.size();
+    }
+    return done.size();
+}
+
+void TextureLoader::upload(Job& job) {
+    if (job.compressedFormat) {
+        glBindTexture(GL_TEXTURE_2D, job.texture);
+        const unsigned char* data = job.blocks.data();
+        GLsizei w = job.width, h = job.height;
+        for (size_t level = 0; level < job.levelSizes.size(); ++level) {
+            glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)level, job.compressedFormat, w, h, 0,
+                                   (GLsizei)job.levelSizes[level], data);
+            data += job.levelSizes[level];
+            w = w > 1 ? w / 2 : 1;
+            h = h > 1 ? h / 2 : 1;
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)job.levelSizes.size() - 1);
+        uploadedBytes[job.texture] = job.blocks.size();
+
+        double sinceStart = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+        std::cout << "Loaded baked texture " << job.path << ".ktx: " << job.width << "x" << job.height << ", "
+                  << job.levelSizes.size() << " levels, " << job.blocks.size() / 1024 << " KB, read in "
+                  << job.decodeMs << " ms, ready " << sinceStart << " ms after start" << std::endl;
+        std::vector<unsigned char>().swap(job.blocks);
+        return;
+    }
+    if (!job.pixels) {
+        std::cerr << "Failed to load texture: " << job.path << std::endl;
+        return;
+    }
+
+    GLenum format = 0;
+    if (job.channels == 1) format = GL_RED;
+    else if (job.channels == 3) format = GL_RGB;
+    else if (job.channels == 4) format = GL_RGBA;
+    if (!format) {
+        std::cerr << "Unsupported channel count in texture: " << job.path << std::endl;
+    } else {
+        glBindTexture(GL_TEXTURE_2D, job.texture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // RGB rows are not 4-byte aligned in general
+        glTexImage2D(GL_TEXTURE_2D, 0, format, job.width, job.height, 0, format, GL_UNSIGNED_BYTE, job.pixels);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        // drivers keep RGB8 as RGBA8; a full mip chain adds a third
+        uploadedBytes[job.texture] = (size_t)job.width * job.height * (job.channels == 1 ? 1 : 4) * 4 / 3;
+
+        double sinceStart = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+        std::cout << "Loaded texture " << job.path << ": " << job.width << "x" << job.height
+                  << ", decoded in " << job.decodeMs << " ms, ready " << sinceStart << " ms after start" << std::endl;
+    }
+    stbi_image_free(job.pixels);
+    job.pixels = nullptr;
+}
+
+void TextureLoader::discard(GLuint texture) {
+    uploadedBytes.erase(texture);
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = queued.begin(); it != queued.end(); ++it)
+        if (it->texture == texture) {
+            queued.erase(it);
+            --inFlight;
+            return;
+        }
+    for (auto it = ready.begin(); it != ready.end(); ++it)
+        if (it->texture == texture) {
+            stbi_image_free(it->pixels);
+            ready.erase(it);
+            --inFlight;
+            return;
+        }
+    for (const auto& d : decoding)
+        if (d.second == texture)
+            cancelled.insert(d.first);
+}
+
+size_t TextureLoader::residentBytes(GLuint texture) const {
+    auto it = uploadedBytes.find(texture);
+    return it == uploadedBytes.end() ? 0 : it->second;
+}
+
+size_t TextureLoader::pending() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return inFlight;
+}
+
+void TextureLoader::finish() {
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            decoded.wait(lock, [this] { return !ready.empty() || inFlight == 0; });
+            if (inFlight == 0) return;
+        }
+        poll();
+    }
+}
+
+void TextureLoader::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& t : workers)
+        t.join();
+    workers.clear();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (Job& job : ready)
+        stbi_image_free(job.pixels);
+    ready.clear();
+    queued.clear();
+    decoding.clear();
+    cancelled.clear();
+    inFlight = 0;
+}
@@ -0,0 +1,112 @@
+// TextureLoader.h
+#pragma once
+
+#include <GL/glew.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Sampler state applied to a texture when it is requested.
+struct TextureSampler {
+    GLenum wrapS = GL_REPEAT;
+    GLenum wrapT = GL_REPEAT;
+    GLenum minFilter = GL_LINEAR_MIPMAP_LINEAR;
+    GLenum magFilter = GL_LINEAR;
+
+    bool operator==(const TextureSampler& o) const {
+        return wrapS == o.wrapS && wrapT == o.wrapT && minFilter == o.minFilter && magFilter == o.magFilter;
+    }
+};
+
+// Decodes image files on worker threads and uploads them on the GL thread.
+// request() returns a texture name right away; it holds a 1x1 grey
+// placeholder until poll() swaps in the decoded image (same name, so
+// callers can bind it immediately and never need to re-fetch it).
+// A current "<image>.ktx" bake (tools/textureBake.cpp) is preferred: its
+// BC1/BC3 mip levels are uploaded as-is. Otherwise stb decodes the image
+// and mipmaps are generated on the GPU.
+class TextureLoader {
+public:
+    TextureLoader() = default;
+    ~TextureLoader() { shutdown(); }
+    TextureLoader(const TextureLoader&) = delete;
+    TextureLoader& operator=(const TextureLoader&) = delete;
+
+    // Worker threads (0 = hardware threads, capped at 8). Set before the first request().
+    unsigned threads = 0;
+
+    // Look for baked .ktx files (ignored when the driver lacks S3TC).
+    bool useBaked = true;
+
+    // GL thread only. Images are flipped vertically like the old loadTexture.
+    GLuint request(const char* path, const TextureSampler& sampler = TextureSampler());
+
+    // GL thread only. Call before deleting a requested texture: drops its
+    // decode if still pending (the name may be reused by the next
+    // glGenTextures) and forgets its size.
+    void discard(GLuint texture);
+
+    // GL thread only. Bytes the texture occupies on the GPU with all mip
+    // levels: the placeholder until it is uploaded, 0 for unknown names.
+    size_t residentBytes(GLuint texture) const;
+
+    // GL thread only. True once poll() has replaced the placeholder.
+    bool isUploaded(GLuint texture) const { return residentBytes(texture) > placeholderBytes; }
+
+    // GL thread only. Uploads up to maxUploads finished images (with mipmaps);
+    // returns how many were uploaded.
+    size_t poll(size_t maxUploads = (size_t)-1);
+
+    // Requests still decoding or waiting for poll().
+    size_t pending() const;
+
+    // Blocks until every request is decoded, then uploads them all.
+    void finish();
+
+    // Stops the workers; decoded but not uploaded images are dropped.
+    void shutdown();
+
+private:
+    struct Job {
+        GLuint texture = 0;
+        uint64_t serial = 0;                    // unique per request, unlike the texture name
+        std::string path;
+        bool tryBaked = false;
+        unsigned char* pixels = nullptr;        // stb path
+        int width = 0, height = 0, channels = 0;
+        uint32_t compressedFormat = 0;          // baked path: BC1/BC3 levels back to back
+        std::vector<unsigned char> blocks;
+        std::vector<uint32_t> levelSizes;
+        double decodeMs = 0.0;
+    };
+
+    static const size_t placeholderBytes = 4;   // 1x1 RGBA8
+
+    void startWorkers();
+    void workerLoop();
+    static bool readBaked(Job& job);
+    void upload(Job& job);
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;       // workers: new job or stop
+    std::condition_variable decoded;    // finish(): a job completed
+    std::deque<Job> queued;
+    std::vector<Job> ready;
+    // Keyed by job serial: a discarded texture's name can be handed out
+    // again while its old decode is still running.
+    std::unordered_map<uint64_t, GLuint> decoding;  // picked up by a worker: serial -> texture
+    std::unordered_set<uint64_t> cancelled;         // discarded while decoding
+    uint64_t nextSerial = 0;
+    size_t inFlight = 0;                // queued + being decoded
+    bool stopping = false;
+    std::vector<std::thread> workers;
+    std::chrono::steady_clock::time_point startTime;
+    std::unordered_map<GLuint, size_t> uploadedBytes;   // GL thread only
+};
@@ -0,0 +1,109 @@
+// VertexPacking.h
+// Compressed GPU layout for Vertex (see Vertex.h), split into two streams so
+// depth-only passes fetch positions alone. Decoded in the vertex shaders.
+#pragma once
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include "Vertex.h"
+
+// Stream 0: position as unorm16 within the mesh bounds (w unused, keeps 8-byte alignment).
+struct PackedPosition {
+    uint16_t x, y, z, pad;
+};
+
+// Stream 1: half-float UV + octahedral normal as snorm16.
+struct PackedAttributes {
+    uint16_t u, v;
+    int16_t  octX, octY;
+};
+static_assert(sizeof(PackedPosition) == 8 && sizeof(PackedAttributes) == 8,
+              "packed streams must stay 8 bytes each");
+
+// Per-mesh dequantisation: position = offset + unorm * scale.
+struct PositionQuantization {
+    glm::vec3 offset = glm::vec3(0.0f);
+    glm::vec3 scale = glm::vec3(1.0f);
+};
+
+// float -> IEEE half, round to nearest even. Out of range saturates to inf.
+inline uint16_t floatToHalf(float f) {
+    uint32_t x;
+    memcpy(&x, &f, 4);
+    uint32_t sign = (x >> 16) & 0x8000u;
+    uint32_t absx = x & 0x7FFFFFFFu;
+    if (absx >= 0x7F800000u)                       // inf / nan
+        return (uint16_t)(sign | 0x7C00u | (absx > 0x7F800000u ? 0x200u : 0u));
+    if (absx >= 0x477FF000u)                       // rounds past 65504
+        return (uint16_t)(sign | 0x7C00u);
+    if (absx < 0x38800000u) {                      // half subnormal or zero
+        if (absx < 0x33000000u) return (uint16_t)sign;
+        uint32_t mant = (absx & 0x007FFFFFu) | 0x00800000u;
+        int shift = 126 - (int)(absx >> 23);       // 14..24
+        uint32_t h = mant >> shift;
+        uint32_t rem = mant & ((1u << shift) - 1u), halfway = 1u << (shift - 1);
+        if (rem > halfway || (rem == halfway && (h & 1u))) ++h;
+        return (uint16_t)(sign | h);
+    }
+    uint32_t h = ((absx - 0x38000000u) >> 13);
+    uint32_t rem = absx & 0x1FFFu;
+    if (rem > 0x1000u || (rem == 0x1000u && (h & 1u))) ++h; // may carry into the exponent, which is correct
+    return (uint16_t)(sign | h);
+}
+
+inline int16_t toSnorm16(float v) {
+    v = glm::clamp(v, -1.0f, 1.0f);
+    return (int16_t)std::lround(v * 32767.0f);
+}
+
+// Unit vector -> octahedron folded onto [-1,1]^2. Zero vectors encode +Z.
+inline glm::vec2 octEncode(glm::vec3 n) {
+    float l1 = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+    if (l1 < 1e-20f) return glm::vec2(0.0f);
+    n /= l1;
+    glm::vec2 e(n.x, n.y);
+    if (n.z < 0.0f) {
+        e = glm::vec2((1.0f - std::fabs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f),
+                      (1.0f - std::fabs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f));
+    }
+    return e;
+}
+
+// Matches octDecode() in the vertex shaders.
+inline glm::vec3 octDecode(glm::vec2 e) {
+    glm::vec3 n(e.x, e.y, 1.0f - std::fabs(e.x) - std::fabs(e.y));
+    float t = glm::clamp(-n.z, 0.0f, 1.0f);
+    n.x += (n.x >= 0.0f) ? -t : t;
+    n.y += (n.y >= 0.0f) ? -t : t;
+    return glm::normalize(n);
+}
+
+inline PositionQuantization quantizationForBounds(const glm::vec3& lo, const glm::vec3& hi) {
+    PositionQuantization q;
+    q.offset = lo;
+    q.scale = (hi - lo) / 65535.0f;  // a flat axis gets scale 0 and decodes to lo
+    return q;
+}
+
+inline PackedPosition packPosition(const glm::vec3& p, const PositionQuantization& q) {
+    PackedPosition out = { 0, 0, 0, 0 };
+    uint16_t* dst[3] = { &out.x, &out.y, &out.z };
+    for (int k = 0; k < 3; ++k) {
+        float t = (q.scale[k] > 0.0f) ? (p[k] - q.offset[k]) / q.scale[k] : 0.0f;
+        *dst[k] = (uint16_t)std::min(std::max(std::lround(t), 0L), 65535L);
+    }
+    return out;
+}
+
+inline PackedAttributes packAttributes(const Vertex& v) {
+    glm::vec2 oct = octEncode(v.normal);
+    PackedAttributes out;
+    out.u = floatToHalf(v.texCoord.x);
+    out.v = floatToHalf(v.texCoord.y);
+    out.octX = toSnorm16(oct.x);
+    out.octY = toSnorm16(oct.y);
+    return out;
+}
@@ -0,0 +1,118 @@
+// VertexWelder.h
+// Welds per-corner OBJ output (loadOBJ*) into a unique Vertex array + indices.
+#pragma once
+
+#include <glm/glm.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "Vertex.h"
+
+// The 32-byte key that is hashed and compared bit for bit.
+struct PackedVertex {
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 texCoord;
+};
+static_assert(sizeof(PackedVertex) == 32, "PackedVertex must be 8 tightly packed floats");
+
+struct WeldStats {
+    size_t corners = 0;      // input corners (3 per triangle)
+    size_t vertices = 0;     // unique vertices after welding
+    size_t tableSlots = 0;   // open-addressing table capacity
+    double milliseconds = 0.0;
+};
+
+// 64-bit mix of all 32 bytes (murmur3-style finalizer per lane).
+inline uint64_t hashPackedVertex(const PackedVertex& v) {
+    uint64_t w[4];
+    memcpy(w, &v, sizeof(w));
+    uint64_t h = 0x9E3779B97F4A7C15ull;
+    for (int i = 0; i < 4; ++i) {
+        uint64_t k = w[i] * 0xFF51AFD7ED558CCDull;
+        k ^= k >> 33;
+        h = (h ^ k) * 0xC4CEB9FE1A85EC53ull;
+        h ^= h >> 29;
+    }
+    return h;
+}
+
+// Deduplicates identical corners. Vertices keep first-occurrence order, so the
+// result matches the old unordered_map welding. The table is sized for about
+// one vertex per two triangles (a closed smooth mesh; pass 0 to count them
+// from the corners) and doubles whenever the load factor would pass 2/3, so
+// seams and flat shading cost a rehash rather than a table sized per corner.
+inline WeldStats weldVertices(const std::vector<glm::vec3>& positions,
+                              const std::vector<glm::vec3>& normals,
+                              const std::vector<glm::vec2>& uvs,
+                              size_t triangleCount,
+                              std::vector<Vertex>& outVertices,
+                              std::vector<unsigned int>& outIndices) {
+    auto t0 = std::chrono::steady_clock::now();
+    WeldStats stats;
+    const size_t corners = positions.size();
+    stats.corners = corners;
+
+    size_t expected = (triangleCount ? triangleCount : corners / 3) / 2;
+    size_t slots = 16;
+    while (slots < expected + expected / 2) slots <<= 1; // load factor <= 2/3
+    size_t mask = slots - 1;
+
+    // slot -> vertex index + 1 (0 = empty); keys live in 'keys' by vertex index
+    std::vector<uint32_t> table(slots, 0);
+    std::vector<PackedVertex> keys;
+    keys.reserve(expected);
+
+    outVertices.clear();
+    outIndices.clear();
+    outVertices.reserve(expected);
+    outIndices.reserve(corners);
+
+    for (size_t i = 0; i < corners; ++i) {
+        PackedVertex key = {
+            positions[i],
+            (i < normals.size()) ? normals[i] : glm::vec3(0.0f),
+            (i < uvs.size()) ? uvs[i] : glm::vec2(0.0f)
+        };
+        // +0.0f folds -0.0 into 0.0 so bitwise equality matches float equality
+        for (int k = 0; k < 3; ++k) { key.position[k] += 0.0f; key.normal[k] += 0.0f; }
+        key.texCoord.x += 0.0f; key.texCoord.y += 0.0f;
+
+        size_t s = (size_t)hashPackedVertex(key) & mask;
+        for (;;) {
+            uint32_t e = table[s];
+            if (e == 0) {
+                uint32_t idx = (uint32_t)keys.size();
+                if ((idx + 1) * 3 > slots * 2) {
+                    // grow: rehash the keys so far, then probe again for this one
+                    slots <<= 1;
+                    mask = slots - 1;
+                    table.assign(slots, 0);
+                    for (uint32_t k = 0; k < idx; ++k) {
+                        size_t r = (size_t)hashPackedVertex(keys[k]) & mask;
+                        while (table[r]) r = (r + 1) & mask;
+                        table[r] = k + 1;
+                    }
+                    s = (size_t)hashPackedVertex(key) & mask;
+                    continue;
+                }
+                table[s] = idx + 1;
+                keys.push_back(key);
+                outVertices.push_back({ key.position, key.texCoord, key.normal });
+                outIndices.push_back(idx);
+                break;
+            }
+            if (memcmp(&keys[e - 1], &key, sizeof(PackedVertex)) == 0) {
+                outIndices.push_back(e - 1);
+                break;
+            }
+            s = (s + 1) & mask; // linear probing
+        }
+    }
+
+    stats.vertices = outVertices.size();
+    stats.tableSlots = slots;
+    stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    return stats;
+}
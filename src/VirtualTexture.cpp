@@ -0,0 +1,392 @@
+#include "VirtualTexture.h"
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+bool VirtualTexture::open(const char* imagePath) {
+    release();
+    std::string file = pageFilePath(imagePath);
+    if (!bakedTextureIsCurrent(file.c_str(), imagePath) || !GLEW_EXT_texture_compression_s3tc)
+        return false;
+    if (!readPageFileInfo(file.c_str(), info)) {
+        std::cerr << "Ignoring invalid page file " << file << std::endl;
+        return false;
+    }
+    const uint32_t levelCount = info.header.levelCount;
+    auto levelPages = [this](uint32_t level) { return info.levels[level].tilesX * info.levels[level].tilesY; };
+
+    // pin the coarse tail: always the last level, more while it stays under 1/16 of the budget
+    uint32_t pinnedFrom = levelCount - 1;
+    uint32_t pinnedPages = levelPages(pinnedFrom);
+    while (pinnedFrom > 0 && pinnedPages + levelPages(pinnedFrom - 1) <= budgetPages / 16)
+        pinnedPages += levelPages(--pinnedFrom);
+
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    slotsPerRow = (uint32_t)std::ceil(std::sqrt((double)budgetPages));
+    slotsPerRow = std::min(slotsPerRow, std::min((uint32_t)maxSize / PAGE_SIZE, 255u)); // slot coords are 8-bit
+    uint32_t slotCount = std::min(budgetPages, slotsPerRow * slotsPerRow);
+    if (slotCount <= pinnedPages || info.levels[0].tilesX > (uint32_t)maxSize) {
+        std::cerr << "Page budget too small for " << file << std::endl;
+        return false;
+    }
+
+    path = file;
+    format = (GLenum)info.header.internalFormat;   // KTX enums are the GL ones
+    slots.assign(slotCount, Slot());
+    pageSlot.assign(info.header.pageCount, -1);
+    pageWanted.assign(info.header.pageCount, 0);
+    pageLoading.assign(info.header.pageCount, 0);
+    levelRow.resize(levelCount);
+    indirectionRows = 0;
+    for (uint32_t l = 0; l < levelCount; ++l) {
+        levelRow[l] = indirectionRows;
+        indirectionRows += info.levels[l].tilesY;
+    }
+    entries.assign((size_t)info.levels[0].tilesX * indirectionRows * 4, 0);
+    counters = Stats();
+    frame = 1;
+
+    GLint previous = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous);
+
+    GLsizei atlasSize = (GLsizei)(slotsPerRow * PAGE_SIZE);
+    glGenTextures(1, &atlas);
+    glBindTexture(GL_TEXTURE_2D, atlas);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, atlasSize, atlasSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+
+    glGenTextures(1, &indirection);
+    glBindTexture(GL_TEXTURE_2D, indirection);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, (GLsizei)info.levels[0].tilesX, (GLsizei)indirectionRows, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+
+    // the pinned tail is a few hundred KB; read it here so the texture is complete from the first frame
+    FILE* f = fopen(path.c_str(), "rb");
+    std::vector<uint8_t> blocks;
+    bool ok = f != nullptr;
+    glBindTexture(GL_TEXTURE_2D, atlas);
+    for (uint32_t page = info.levels[pinnedFrom].firstPage; ok && page < info.header.pageCount; ++page) {
+        ok = readPage(f, page, blocks);
+        if (ok) upload(page, blocks, true);
+    }
+    if (f) fclose(f);
+    glBindTexture(GL_TEXTURE_2D, (GLuint)previous);
+    if (!ok) {
+        std::cerr << "Failed to read page file " << path << std::endl;
+        release();
+        return false;
+    }
+    rebuildIndirection();
+
+    stopping = false;
+    reader = std::thread(&VirtualTexture::readerLoop, this);
+
+    std::cout << "Opened virtual texture " << path << ": " << info.header.width << "x" << info.header.height
+              << ", " << levelCount << " levels, " << info.header.pageCount << " pages, atlas " << atlasSize
+              << "x" << atlasSize << " (" << slotCount << " slots, "
+              << (size_t)slotCount * info.header.pageBytes / 1024 << " KB), " << pinnedPages << " pinned" << std::endl;
+    return true;
+}
+
+bool VirtualTexture::readPage(FILE* f, uint32_t page, std::vector<uint8_t>& blocks) const {
+#ifdef _WIN32
+    if (_fseeki64(f, (long long)info.pageOffset(page), SEEK_SET) != 0) return false;
+#else
+    if (fseeko(f, (off_t)info.pageOffset(page), SEEK_SET) != 0) return false;
+#endif
+    blocks.resize(info.header.pageBytes);
+    return fread(blocks.data(), 1, blocks.size(), f) == blocks.size();
+}
+
+void VirtualTexture::readerLoop() {
+    FILE* f = fopen(path.c_str(), "rb");
+    for (;;) {
+        Read read;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || !queued.empty(); });
+            if (stopping) break;
+            read.page = queued.front();
+            queued.pop_front();
+        }
+        // a failed read comes back empty so the page can be requested again
+        if (!f || !readPage(f, read.page, read.blocks))
+            read.blocks.clear();
+        std::lock_guard<std::mutex> lock(mutex);
+        done.push_back(std::move(read));
+    }
+    if (f) fclose(f);
+}
+
+// Empty slot first, else the least recently used unpinned page that this
+// frame has not asked for. -1 when the working set fills the atlas.
+int VirtualTexture::freeSlot() {
+    int best = -1;
+    for (size_t i = 0; i < slots.size(); ++i) {
+        const Slot& s = slots[i];
+        if (s.page < 0) return (int)i;
+        if (s.pinned || s.lastUsed >= frame) continue;
+        if (best < 0 || s.lastUsed < slots[best].lastUsed) best = (int)i;
+    }
+    return best;
+}
+
+// Expects the atlas to be bound.
+void VirtualTexture::upload(uint32_t page, const std::vector<uint8_t>& blocks, bool pinned) {
+    int slot = freeSlot();
+    if (slot < 0) {
+        ++counters.dropped;
+        return;
+    }
+    Slot& s = slots[slot];
+    if (s.page >= 0) {
+        pageSlot[s.page] = -1;
+        ++counters.evicted;
+    }
+    s.page = (int32_t)page;
+    s.lastUsed = frame;
+    s.pinned = pinned;
+    pageSlot[page] = slot;
+
+    GLint x = (GLint)((slot % slotsPerRow) * PAGE_SIZE), y = (GLint)((slot / slotsPerRow) * PAGE_SIZE);
+    glCompressedTexSubImage2D(GL_TEXTURE_2D, 0, x, y, PAGE_SIZE, PAGE_SIZE, format,
+                              (GLsizei)blocks.size(), blocks.data());
+    indirectionDirty = true;
+}
+
+void VirtualTexture::beginFrame() {
+    ++frame;
+    wanted.clear();
+}
+
+void VirtualTexture::requestTile(uint32_t level, uint32_t tx, uint32_t ty) {
+    const PageLevel& l = info.levels[level];
+    uint32_t page = l.firstPage + ty * l.tilesX + tx;
+    if (pageWanted[page] == frame) return;
+    pageWanted[page] = frame;
+    wanted.push_back(page);
+    if (pageSlot[page] >= 0)
+        slots[pageSlot[page]].lastUsed = frame;
+}
+
+void VirtualTexture::requestSphere(const glm::mat4& model, const glm::vec3& center, float radius, const LodView& view) {
+    if (!isOpen()) return;
+
+    glm::vec3 c = glm::vec3(model * glm::vec4(center, 1.0f));
+    float scale = std::max(glm::length(glm::vec3(model[0])),
+                  std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+    float r = radius * scale;
+    if (r <= 0.0f) return;
+    glm::mat3 rotation = glm::mat3(model) / scale;   // planets are scaled uniformly
+    glm::vec3 toCamera = view.cameraPos - c;
+    bool inside = glm::length(toCamera) <= r;
+
+    // level-0 texels per world unit along the equator, over pixels per world unit at distance 1
+    float texelsPerPixelAt1 = (float)info.header.width / (glm::two_pi<float>() * r) / view.pixelsPerUnit;
+
+    // breadth first from the single coarsest tile; a visible tile is
+    // requested and split while its level is coarser than its texel density
+    // calls for, and the refinement stops before it would overflow the atlas
+    const float T = (float)PAGE_TILE_SIZE;
+    std::vector<glm::uvec2> tiles, children;
+    const uint32_t last = info.header.levelCount - 1;
+    for (uint32_t ty = 0; ty < info.levels[last].tilesY; ++ty)
+        for (uint32_t tx = 0; tx < info.levels[last].tilesX; ++tx)
+            tiles.push_back(glm::uvec2(tx, ty));
+
+    for (uint32_t level = last;; --level) {
+        const PageLevel& l = info.levels[level];
+        children.clear();
+        for (const glm::uvec2& t : tiles) {
+            float u0 = t.x * T / l.width, u1 = std::min((t.x + 1) * T, (float)l.width) / l.width;
+            float v0 = t.y * T / l.height, v1 = std::min((t.y + 1) * T, (float)l.height) / l.height;
+
+            bool visible = inside;
+            float nearest = std::max(glm::length(toCamera) - r, 1e-4f);
+            if (!inside && u1 - u0 <= 0.25f) {
+                // nine points of the patch: (u, v) -> sphere.obj direction, u = longitude from +X towards +Z
+                nearest = 1e30f;
+                for (int j = 0; j <= 2; ++j)
+                    for (int i = 0; i <= 2; ++i) {
+                        float lon = glm::two_pi<float>() * (u0 + (u1 - u0) * 0.5f * i);
+                        float lat = glm::pi<float>() * (v0 + (v1 - v0) * 0.5f * j - 0.5f);
+                        glm::vec3 n = rotation * glm::vec3(cosf(lat) * cosf(lon), sinf(lat), cosf(lat) * sinf(lon));
+                        visible = visible || glm::dot(n, toCamera) > r * 0.98f;   // in front of the horizon
+                        nearest = std::min(nearest, glm::length(c + n * r - view.cameraPos));
+                    }
+            } else if (!inside) {
+                visible = true;   // patch wider than a quarter turn: the sample grid is too coarse to cull it
+            }
+            if (!visible) continue;
+
+            requestTile(level, t.x, t.y);
+            float texelsPerPixel = texelsPerPixelAt1 * std::max(nearest, 1e-4f);
+            int needed = (int)std::floor(std::log2(std::max(texelsPerPixel, 1.0f)));
+            if (level > 0 && needed < (int)level) {
+                const PageLevel& child = info.levels[level - 1];
+                for (uint32_t cy = t.y * 2; cy <= std::min(t.y * 2 + 1, child.tilesY - 1); ++cy)
+                    for (uint32_t cx = t.x * 2; cx <= std::min(t.x * 2 + 1, child.tilesX - 1); ++cx)
+                        children.push_back(glm::uvec2(cx, cy));
+            }
+        }
+        if (level == 0 || children.empty() || wanted.size() + children.size() > slots.size())
+            break;
+        tiles.swap(children);
+    }
+}
+
+void VirtualTexture::update() {
+    if (!isOpen()) return;
+
+    std::vector<Read> arrived;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t n = std::min((size_t)maxUploadsPerFrame, done.size());
+        arrived.assign(std::make_move_iterator(done.begin()), std::make_move_iterator(done.begin() + n));
+        done.erase(done.begin(), done.begin() + n);
+        inFlight -= n;
+    }
+    if (!arrived.empty()) {
+        GLint previous = 0;
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous);
+        glBindTexture(GL_TEXTURE_2D, atlas);
+        for (const Read& read : arrived) {
+            pageLoading[read.page] = 0;
+            if (read.blocks.empty() || pageSlot[read.page] >= 0) continue;
+            size_t before = counters.dropped;
+            upload(read.page, read.blocks, false);
+            if (counters.dropped == before) ++counters.streamed;
+        }
+        glBindTexture(GL_TEXTURE_2D, (GLuint)previous);
+    }
+
+    // queue misses coarse first (coarser levels have higher page numbers), so
+    // the fallback sharpens one level at a time instead of waiting on level 0
+    std::vector<uint32_t> missing;
+    for (uint32_t page : wanted)
+        if (pageSlot[page] < 0 && !pageLoading[page]) missing.push_back(page);
+    std::sort(missing.begin(), missing.end(), [](uint32_t a, uint32_t b) { return a > b; });
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (uint32_t page : missing) {
+            if (inFlight >= maxInFlight) break;
+            queued.push_back(page);
+            pageLoading[page] = 1;
+            ++inFlight;
+        }
+    }
+    wake.notify_one();
+
+    counters.wanted = wanted.size();
+    if (indirectionDirty)
+        rebuildIndirection();
+}
+
+// Every tile gets its own slot or, failing that, its parent's entry, so a
+// lookup always lands on the finest resident page covering the texel.
+// Entry: slot x, slot y, resident level, 255 = valid.
+void VirtualTexture::rebuildIndirection() {
+    const uint32_t width = info.levels[0].tilesX;
+    const uint32_t levelCount = info.header.levelCount;
+    for (uint32_t level = levelCount; level-- > 0;) {
+        const PageLevel& l = info.levels[level];
+        for (uint32_t ty = 0; ty < l.tilesY; ++ty)
+            for (uint32_t tx = 0; tx < l.tilesX; ++tx) {
+                uint8_t* e = &entries[((size_t)(levelRow[level] + ty) * width + tx) * 4];
+                int32_t slot = pageSlot[l.firstPage + ty * l.tilesX + tx];
+                if (slot >= 0) {
+                    e[0] = (uint8_t)(slot % slotsPerRow);
+                    e[1] = (uint8_t)(slot / slotsPerRow);
+                    e[2] = (uint8_t)level;
+                    e[3] = 255;
+                } else if (level + 1 < levelCount) {
+                    const PageLevel& p = info.levels[level + 1];
+                    uint32_t px = std::min(tx / 2, p.tilesX - 1), py = std::min(ty / 2, p.tilesY - 1);
+                    memcpy(e, &entries[((size_t)(levelRow[level + 1] + py) * width + px) * 4], 4);
+                } else {
+                    e[0] = e[1] = e[3] = 0;
+                    e[2] = (uint8_t)level;
+                }
+            }
+    }
+
+    GLint previous = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous);
+    glBindTexture(GL_TEXTURE_2D, indirection);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, (GLsizei)width, (GLsizei)indirectionRows, GL_RGBA, GL_UNSIGNED_BYTE,
+                    entries.data());
+    glBindTexture(GL_TEXTURE_2D, (GLuint)previous);
+    indirectionDirty = false;
+}
+
+void VirtualTexture::bind(GLuint program, GLuint indirectionUnit, GLuint atlasUnit) const {
+    glActiveTexture(GL_TEXTURE0 + indirectionUnit);
+    glBindTexture(GL_TEXTURE_2D, indirection);
+    glActiveTexture(GL_TEXTURE0 + atlasUnit);
+    glBindTexture(GL_TEXTURE_2D, atlas);
+    glActiveTexture(GL_TEXTURE0);
+
+    float levels[PAGE_MAX_LEVELS * 4] = {};
+    for (uint32_t l = 0; l < info.header.levelCount; ++l) {
+        levels[l * 4 + 0] = (float)info.levels[l].width;
+        levels[l * 4 + 1] = (float)info.levels[l].height;
+        levels[l * 4 + 2] = (float)levelRow[l];
+    }
+    if (program != uniformProgram) {
+        uniformProgram = program;
+        uniforms.useVirtualTexture = glGetUniformLocation(program, "useVirtualTexture");
+        uniforms.indirection = glGetUniformLocation(program, "vtIndirection");
+        uniforms.atlas = glGetUniformLocation(program, "vtAtlas");
+        uniforms.levels = glGetUniformLocation(program, "vtLevels");
+        uniforms.levelCount = glGetUniformLocation(program, "vtLevelCount");
+        uniforms.page = glGetUniformLocation(program, "vtPage");
+    }
+    glUniform1i(uniforms.useVirtualTexture, 1);
+    glUniform1i(uniforms.indirection, (GLint)indirectionUnit);
+    glUniform1i(uniforms.atlas, (GLint)atlasUnit);
+    glUniform4fv(uniforms.levels, (GLsizei)info.header.levelCount, levels);
+    glUniform1i(uniforms.levelCount, (GLint)info.header.levelCount);
+    glUniform4f(uniforms.page, (float)PAGE_TILE_SIZE, (float)PAGE_BORDER,
+                (float)PAGE_SIZE, (float)(slotsPerRow * PAGE_SIZE));
+}
+
+VirtualTexture::Stats VirtualTexture::stats() const {
+    Stats s = counters;
+    s.resident = 0;
+    for (const Slot& slot : slots)
+        if (slot.page >= 0) ++s.resident;
+    return s;
+}
+
+void VirtualTexture::release() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (reader.joinable())
+        reader.join();
+    queued.clear();
+    done.clear();
+    inFlight = 0;
+
+    if (atlas) glDeleteTextures(1, &atlas);
+    if (indirection) glDeleteTextures(1, &indirection);
+    atlas = indirection = 0;
+    slots.clear();
+    pageSlot.clear();
+    pageWanted.clear();
+    pageLoading.clear();
+    wanted.clear();
+    entries.clear();
+    info.levels.clear();
+}
@@ -0,0 +1,125 @@
+// VirtualTexture.h
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "MeshCache.h"
+#include "PageFile.h"
+
+// Streams a page file (tools/textureBake.cpp -p) into a fixed-size atlas, so
+// a 16k planet map costs budgetPages pages of GPU memory instead of the whole
+// mip chain. Each frame the GL thread works out which pages the planets need
+// from their projected size (requestSphere), a background thread reads missing
+// pages from disk, and update() uploads them into free or least recently used
+// slots. An indirection texture maps every tile of every level to its slot,
+// or to the nearest resident coarser page while a page is still streaming.
+// The coarsest levels are read in open() and never evicted.
+class VirtualTexture {
+public:
+    VirtualTexture() = default;
+    ~VirtualTexture() { release(); }
+    VirtualTexture(const VirtualTexture&) = delete;
+    VirtualTexture& operator=(const VirtualTexture&) = delete;
+
+    // Atlas slots of PAGE_SIZE^2 texels; fixed by open(). 1024 BC1 pages = 8 MB.
+    unsigned budgetPages = 1024;
+    // Disk reads queued at once, and pages uploaded per update().
+    unsigned maxInFlight = 32;
+    unsigned maxUploadsPerFrame = 16;
+
+    // GL thread. Opens "<imagePath>.pages" if it is current; false when there
+    // is none, it is invalid, or the driver lacks S3TC.
+    bool open(const char* imagePath);
+    bool isOpen() const { return atlas != 0; }
+
+    // Per frame, GL thread: beginFrame(), requestSphere() for every object
+    // drawn with this texture, then update().
+    void beginFrame();
+
+    // Marks the pages a UV sphere (sphere.obj mapping: u = longitude,
+    // v = latitude) needs: the tiles on the camera-facing side, at the level
+    // where one texel covers about a pixel at each tile's distance.
+    void requestSphere(const glm::mat4& model, const glm::vec3& center, float radius, const LodView& view);
+
+    // Uploads finished reads, queues reads for missing pages, refreshes the
+    // indirection texture.
+    void update();
+
+    // Binds the indirection and atlas textures and sets the vt* uniforms of
+    // the current program (fragmentShader.glsl), including useVirtualTexture.
+    // Uniform locations are looked up the first time a program is bound.
+    void bind(GLuint program, GLuint indirectionUnit, GLuint atlasUnit) const;
+
+    struct Stats {
+        size_t resident = 0;    // pages in the atlas
+        size_t wanted = 0;      // pages requested this frame
+        size_t streamed = 0;    // pages read and uploaded since open()
+        size_t evicted = 0;
+        size_t dropped = 0;     // reads discarded: no slot outside this frame's working set
+    };
+    Stats stats() const;
+
+    // Stops the reader and deletes the GL textures.
+    void release();
+
+private:
+    struct Slot {
+        int32_t  page = -1;
+        uint32_t lastUsed = 0;
+        bool     pinned = false;
+    };
+    struct Read {
+        uint32_t page = 0;
+        std::vector<uint8_t> blocks;
+    };
+
+    void readerLoop();
+    bool readPage(FILE* f, uint32_t page, std::vector<uint8_t>& blocks) const;
+    void upload(uint32_t page, const std::vector<uint8_t>& blocks, bool pinned);
+    int  freeSlot();
+    void requestTile(uint32_t level, uint32_t tx, uint32_t ty);
+    void rebuildIndirection();
+
+    // vt* uniform locations of the program last given to bind()
+    struct UniformLocations {
+        GLint useVirtualTexture = -1, indirection = -1, atlas = -1;
+        GLint levels = -1, levelCount = -1, page = -1;
+    };
+
+    std::string path;
+    PageFileInfo info;
+    GLuint atlas = 0, indirection = 0;
+    GLenum format = 0;
+    uint32_t slotsPerRow = 0;
+    uint32_t indirectionRows = 0;
+    std::vector<uint32_t> levelRow;         // first indirection row of each level
+
+    std::vector<Slot> slots;
+    std::vector<int32_t> pageSlot;          // -1 when not resident
+    std::vector<uint32_t> pageWanted;       // last frame the page was requested
+    std::vector<uint8_t> pageLoading;
+    std::vector<uint32_t> wanted;           // this frame, unique
+    std::vector<uint8_t> entries;           // CPU copy of the indirection texture
+    uint32_t frame = 1;
+    bool indirectionDirty = false;
+    Stats counters;
+    mutable GLuint uniformProgram = 0;
+    mutable UniformLocations uniforms;
+
+    // reader thread
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<uint32_t> queued;
+    std::vector<Read> done;
+    size_t inFlight = 0;
+    bool stopping = false;
+    std::thread reader;
+};
@@ -1,4 +1,3 @@
-#include "../OBJloader.h" // from Tut05
 #include <vector>
 #include <GL/glew.h>
 #include "Vertex.h" // from src/Vertex.h
@@ -13,7 +12,21 @@
 #include <fstream>
 #include <sstream>
 #include <unordered_map>
-#include "SceneNode.h" // from src/SceneNode.h
+#include <functional>
+#include "SceneGraph.h" // from src/SceneGraph.h
+#include "JobSystem.h" // from src/JobSystem.h
+#include "FrameGraph.h" // from src/FrameGraph.h
+#include "Frustum.h" // from src/Frustum.h
+#include "ShadowCache.h" // from src/ShadowCache.h
+#include "CascadedShadowMap.h" // from src/CascadedShadowMap.h
+#include "ShadowSettings.h" // from src/ShadowSettings.h
+#include "MeshCache.h" // from src/MeshCache.h
+#include "TextureLoader.h" // from src/TextureLoader.h
+#include "TextureCache.h" // from src/TextureCache.h
+#include "VirtualTexture.h" // from src/VirtualTexture.h
+#include "Skybox.h" // from src/Skybox.h
+#include "SphereRenderer.h" // from src/SphereRenderer.h
+#include "AsteroidBelt.h" // from src/AsteroidBelt.h
 #include <cmath>
 #include "gameUI.h"
 #include <cstdio>
@@ -61,15 +74,22 @@ GLuint compileShader(GLenum type, const char* source) {
     return shader;
 }
 
-GLuint createShaderProgram(const char* vertPath, const char* fragPath) {
+// geomPath is optional (nullptr: no geometry shader)
+GLuint createShaderProgram(const char* vertPath, const char* fragPath, const char* geomPath = nullptr) {
     std::string vertCode = loadShaderSource(vertPath);
     std::string fragCode = loadShaderSource(fragPath);
     
     GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertCode.c_str());
     GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragCode.c_str());
+    GLuint geometryShader = 0;
+    if (geomPath) {
+        std::string geomCode = loadShaderSource(geomPath);
+        geometryShader = compileShader(GL_GEOMETRY_SHADER, geomCode.c_str());
+    }
 
     GLuint sceneProgram = glCreateProgram();
     glAttachShader(sceneProgram, vertexShader);
+    if (geometryShader) glAttachShader(sceneProgram, geometryShader);
     glAttachShader(sceneProgram, fragmentShader);
     glLinkProgram(sceneProgram);
 
@@ -84,10 +104,33 @@ GLuint createShaderProgram(const char* vertPath, const char* fragPath) {
 
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
+    if (geometryShader) glDeleteShader(geometryShader);
 
     return sceneProgram;
 }
 
+// Vertex-only program whose output 'varying' is captured by transform feedback
+GLuint createFeedbackProgram(const char* vertPath, const char* varying) {
+    std::string vertCode = loadShaderSource(vertPath);
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertCode.c_str());
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glTransformFeedbackVaryings(program, 1, &varying, GL_INTERLEAVED_ATTRIBS);
+    glLinkProgram(program);
+
+    GLint success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        char log[512];
+        glGetProgramInfoLog(program, 512, nullptr, log);
+        std::cerr << "Shader program linking error:\n" << log << std::endl;
+    }
+
+    glDeleteShader(vertexShader);
+    return program;
+}
+
 // Game state
 int    shotsLeft   = 3;
 int    totalScore  = 0;
@@ -181,6 +224,9 @@ const float fastSpeed    = 3.0f;
 bool pPressedLastFrame = false;
 bool renderGalaxy      = true;
 
+// shadow quality tier cycle
+bool oPressedLastFrame = false;
+
 //fine tune the speed of the simulation
 const float DAYS_PER_SECOND   = 1.0f;
 const float SUN_DAY           = 27.0f;   
@@ -191,15 +237,35 @@ const float MARS_YEAR         = 687.0f;
 const float MOON_MONTH        = 27.3f;
 
 
-// Vertex structure for the sphere model
-std::vector<Vertex> sphereVertices;
-std::vector<unsigned int> sphereIndices;
-GLuint sphereVAO, sphereVBO, sphereEBO;
-
-// Station mesh buffers
-std::vector<Vertex> stationVertices;
-std::vector<unsigned int> stationIndices;
-GLuint stationVAO = 0, stationVBO = 0, stationEBO = 0;
+// Meshes (sphere, station) packed into one shared VAO/VBO/EBO
+MeshCache meshCache;
+MeshHandle sphereMesh;
+MeshHandle stationMesh;
+LodView lodView;  // camera terms for per-draw LOD selection, updated every frame
+
+// Textures decode on worker threads, placeholders until uploaded
+TextureLoader textureLoader;
+// one GL texture per path + sampler, deleted when its last handle goes away
+TextureCache textureCache(textureLoader);
+// Planet maps stream page by page when a "<image>.pages" bake exists (16k maps)
+VirtualTexture earthVT, marsVT, moonVT;
+// galaxy background, built from galaxy.jpg once it has been uploaded
+Skybox skybox;
+// sun, planets, moon and shooting star drawn instanced; body maps in one texture array
+SphereRenderer sphereRenderer;
+const int LAYER_SUN = 0, LAYER_EARTH = 1, LAYER_MARS = 2, LAYER_MOON = 3, BODY_LAYERS = 4;
+// asteroids between the Mars and Earth orbits, animated on the GPU
+AsteroidBelt asteroidBelt;
+const size_t ASTEROID_COUNT = 100000;
+// per-frame CPU work: worker threads, and the tasks of the current frame
+JobSystem jobs;
+FrameGraph frameGraph;
+// frustum culling: one frustum and set of counters per pass
+enum CullPass { CULL_CAMERA, CULL_CASCADE, CULL_LIGHT2 = CULL_CASCADE + CascadedShadowMap::MAX_CASCADES, CULL_PASSES };
+const char* const CULL_PASS_NAMES[CULL_PASSES] = { "camera", "light 1 cascade 0", "cascade 1", "cascade 2",
+                                                   "cascade 3", "light 2 cube" };
+CullStats cullTotals[CULL_PASSES];
+size_t cullFrames = 0;
 
 
 // Orbit line variables declare
@@ -226,162 +292,6 @@ GLuint trailVAO, trailVBO;
 //ground plane VAO,VBO,EBO for vasting shadows on
 GLuint groundVAO=0, groundVBO=0, groundEBO=0;
 
-// Load the sphere model from an OBJ file
-bool loadSphereModel(const char *path) {
-    std::vector<glm::vec3> positions, normals;
-    std::vector<glm::vec2> uvs;
-    std::vector<unsigned int> indices;
-
-    if (!loadOBJ(path, positions, normals, uvs, indices)) {
-        std::cerr << "Failed to load " << path << std::endl;
-        return false;
-    }
-
-    struct PackedVertex {
-        glm::vec3 position;
-        glm::vec3 normal;
-        glm::vec2 texCoord;
-
-        bool operator==(const PackedVertex& other) const {
-            return position == other.position && normal == other.normal && texCoord == other.texCoord;
-        }
-    };
-
-    struct Hasher {
-        size_t operator()(const PackedVertex& v) const {
-            size_t h1 = std::hash<float>()(v.position.x) ^ std::hash<float>()(v.position.y) ^ std::hash<float>()(v.position.z);
-            size_t h2 = std::hash<float>()(v.normal.x) ^ std::hash<float>()(v.normal.y) ^ std::hash<float>()(v.normal.z);
-            size_t h3 = std::hash<float>()(v.texCoord.x) ^ std::hash<float>()(v.texCoord.y);
-            return h1 ^ h2 ^ h3;
-        }
-    };
-
-    std::unordered_map<PackedVertex, unsigned int, Hasher> vertexToIndex;
-    sphereVertices.clear();
-    sphereIndices.clear();
-
-    for (size_t i = 0; i < positions.size(); ++i) {
-        PackedVertex packed = {
-            positions[i],
-            (i < normals.size()) ? normals[i] : glm::vec3(0.0f),
-            (i < uvs.size()) ? uvs[i] : glm::vec2(0.0f)
-        };
-
-        auto it = vertexToIndex.find(packed);
-        if (it != vertexToIndex.end()) {
-            sphereIndices.push_back(it->second);
-        } else {
-            sphereVertices.push_back({ packed.position, packed.texCoord, packed.normal });
-            unsigned int newIndex = static_cast<unsigned int>(sphereVertices.size() - 1);
-            vertexToIndex[packed] = newIndex;
-            sphereIndices.push_back(newIndex);
-        }
-    }
-
-    // Upload to GPU
-    glGenVertexArrays(1, &sphereVAO);
-    glGenBuffers(1, &sphereVBO);
-    glGenBuffers(1, &sphereEBO);
-
-    glBindVertexArray(sphereVAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, sphereVBO);
-    glBufferData(GL_ARRAY_BUFFER, sphereVertices.size() * sizeof(Vertex), sphereVertices.data(), GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sphereEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sphereIndices.size() * sizeof(unsigned int), sphereIndices.data(), GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
-    glEnableVertexAttribArray(2);
-
-    glBindVertexArray(0);
-    return true;
-
-}
-
-bool loadModelToBuffers(const char* path,
-                        GLuint& VAO, GLuint& VBO, GLuint& EBO,
-                        std::vector<Vertex>& vertices,
-                        std::vector<unsigned int>& indices) {
-    std::vector<glm::vec3> positions, normals;
-    std::vector<glm::vec2> uvs;
-    std::vector<unsigned int> objIndices;
-
-    if (!loadOBJ(path, positions, normals, uvs, objIndices)) {
-        std::cerr << "Failed to load " << path << std::endl;
-        return false;
-    }
-
-    struct PackedVertex {
-        glm::vec3 position;
-        glm::vec3 normal;
-        glm::vec2 texCoord;
-        bool operator==(const PackedVertex& other) const {
-            return position == other.position &&
-                   normal == other.normal &&
-                   texCoord == other.texCoord;
-        }
-    };
-
-    struct Hasher {
-        size_t operator()(const PackedVertex& v) const {
-            size_t h1 = std::hash<float>()(v.position.x) ^ std::hash<float>()(v.position.y) ^ std::hash<float>()(v.position.z);
-            size_t h2 = std::hash<float>()(v.normal.x) ^ std::hash<float>()(v.normal.y) ^ std::hash<float>()(v.normal.z);
-            size_t h3 = std::hash<float>()(v.texCoord.x) ^ std::hash<float>()(v.texCoord.y);
-            return h1 ^ h2 ^ h3;
-        }
-    };
-
-    std::unordered_map<PackedVertex, unsigned int, Hasher> vertexToIndex;
-    vertices.clear();
-    indices.clear();
-
-    for (size_t i = 0; i < positions.size(); ++i) {
-        PackedVertex packed = {
-            positions[i],
-            (i < normals.size()) ? normals[i] : glm::vec3(0.0f),
-            (i < uvs.size()) ? uvs[i] : glm::vec2(0.0f)
-        };
-
-        auto it = vertexToIndex.find(packed);
-        if (it != vertexToIndex.end()) {
-            indices.push_back(it->second);
-        } else {
-            vertices.push_back({ packed.position, packed.texCoord, packed.normal });
-            unsigned int newIndex = static_cast<unsigned int>(vertices.size() - 1);
-            vertexToIndex[packed] = newIndex;
-            indices.push_back(newIndex);
-        }
-    }
-
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
-
-    glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
-    glEnableVertexAttribArray(2);
-
-    glBindVertexArray(0);
-    return true;
-}
-
-
 //set up camera
 bool tabPressedLastFrame = false;
 const float cameraSpeed = 2.5f;
@@ -398,88 +308,24 @@ void drawSphere() {
 // depth-only draw helper for shadow pass
 void drawSphereDepth(GLuint prog, const glm::mat4& M, GLuint modelLocShadow){
     glUniformMatrix4fv(modelLocShadow, 1, GL_FALSE, glm::value_ptr(M));
-    glBindVertexArray(sphereVAO);
-    glDrawElements(GL_TRIANGLES, (GLsizei)sphereIndices.size(), GL_UNSIGNED_INT, 0);
+    meshCache.bindDepthOnly();
+    sphereMesh.draw();
     glBindVertexArray(0);
 }
 
-// Yibo Tang: Insert the texture
-GLuint loadTexture(const char* filename) {   
-    stbi_set_flip_vertically_on_load(true); // Flip the image vertically
-    GLuint textureID;
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
-
-    // Texture parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);	
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    //Load image using stb_image
-    int width, height, nrChannels;
-    unsigned char *data = stbi_load(filename, &width, &height, &nrChannels, 0);
-    
-    if (data) {
-        GLenum format;
-        if (nrChannels == 1) format = GL_RED;
-        else if (nrChannels == 3) format = GL_RGB;
-        else if (nrChannels == 4) format = GL_RGBA;
-        else {
-            std::cerr << "Unsupported channel count in texture: " << filename << std::endl;
-            stbi_image_free(data);
-            return 0;
-        }
-        //std::cout << "Loaded texture " << filename << ": " << width << "x" << height << " Channels: " << nrChannels << std::endl;
-
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-    } else {
-        std::cerr << "Failed to load texture: " << filename << std::endl;
-    }
-    stbi_image_free(data);
-    return textureID;
+void printCullStats() {
+    if (!cullFrames) return;
+    std::cout << "Culling, per frame over " << cullFrames << " frames (drawn / culled):";
+    for (int p = 0; p < CULL_PASSES; ++p)
+        std::cout << (p ? ", " : " ") << CULL_PASS_NAMES[p] << " "
+                  << (double)cullTotals[p].drawn / cullFrames << " / " << (double)cullTotals[p].culled / cullFrames;
+    std::cout << std::endl;
 }
 
-//clean up helper function
- void deleteSceneGraph(SceneNode* node){
-    for (SceneNode* child : node->children) {
-        deleteSceneGraph(child);
-    }
-    delete node;
-}
-
-//spacestation obj model debug helper fuctions
-static bool hasAnyUVs(const std::vector<Vertex>& v){
-    for (const auto& x : v) if (x.texCoord.x != 0.0f || x.texCoord.y != 0.0f) return true;
-    return false;
-}
-static bool hasAnyNormals(const std::vector<Vertex>& v){
-    for (const auto& x : v) if (glm::dot(x.normal , x.normal) > 1e-10f) return true;
-    return false;
-}
-static void generateSphericalUVs(std::vector<Vertex>& v){
-    for (auto& x : v){
-        glm::vec3 p = glm::normalize(x.position);
-        float u = 0.5f + atan2f(p.z, p.x) / (2.0f * glm::pi<float>());
-        float vcoord = 0.5f - asinf(p.y) / glm::pi<float>();
-        x.texCoord = glm::vec2(u, vcoord);
-    }
-}
-static void recomputeNormals(std::vector<Vertex>& v, const std::vector<unsigned int>& idx){
-    for (auto& x : v) x.normal = glm::vec3(0.0f);
-    for (size_t i = 0; i + 2 < idx.size(); i += 3){
-        Vertex& a = v[idx[i+0]];
-        Vertex& b = v[idx[i+1]];
-        Vertex& c = v[idx[i+2]];
-        glm::vec3 n = glm::normalize(glm::cross(b.position - a.position, c.position - a.position));
-        if (!std::isfinite(n.x)) continue;
-        a.normal += n; b.normal += n; c.normal += n;
-    }
-    for (auto& x : v){
-        float L2 = glm::dot(x.normal, x.normal);
-        x.normal = (L2 > 1e-12f) ? glm::normalize(x.normal) : glm::vec3(0,1,0);
-    }
+void printTextureStats() {
+    TextureCache::Stats st = textureCache.stats();
+    std::cout << "Textures: " << st.textures << " resident, " << st.bytesResident / 1024 << " KB, "
+              << st.hits << " hits, " << st.misses << " misses, " << st.freed << " freed" << std::endl;
 }
 
 int main() {
@@ -511,6 +357,15 @@ int main() {
         return -1;
     }
 
+    // Textures: decoding starts now and overlaps shader/FBO setup and mesh loading;
+    // each texture shows a grey placeholder until textureLoader.poll() uploads it
+    TextureHandle sunTexture = textureCache.acquire("texture/sun.jpg");
+    // planets with a page file skip the flat texture entirely
+    TextureHandle earthTexture = earthVT.open("texture/earth.jpg") ? TextureHandle() : textureCache.acquire("texture/earth.jpg");
+    TextureHandle marsTexture = marsVT.open("texture/mars.jpg") ? TextureHandle() : textureCache.acquire("texture/mars.jpg");
+    TextureHandle moonTexture = moonVT.open("texture/moon.jpg") ? TextureHandle() : textureCache.acquire("texture/moon.jpg");
+    TextureHandle galaxyTexture = textureCache.acquire("texture/galaxy.jpg");
+
     // wrap game UI
     UI::Init();
     laserProg = laserProgram(LASER_VERT, LASER_FRAG);
@@ -542,38 +397,39 @@ int main() {
     // Enable depth testing
     glEnable(GL_DEPTH_TEST);
 
-    // Shadow map1 setup for static up right corner light
-    const GLuint SHADOW_W = 2048, SHADOW_H = 2048;
-    GLuint depthFBO, depthTex;
-    glGenFramebuffers(1, &depthFBO);
-    glGenTextures(1, &depthTex);
-    glBindTexture(GL_TEXTURE_2D, depthTex);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT,
-                SHADOW_W, SHADOW_H, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-    float borderCol[4] = {1,1,1,1};
-    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderCol);
-
-    glBindFramebuffer(GL_FRAMEBUFFER, depthFBO);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTex, 0);
-    glDrawBuffer(GL_NONE);
-    glReadBuffer(GL_NONE);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    // Shadow quality: sizes, formats, PCF and update rates of both lights' maps ('O' cycles)
+    ShadowSettings shadowSettings;
+    GpuFrameTimer gpuFrameTimer;    // feeds the auto tier
+    gpuFrameTimer.init();
+
+    // Shadow map1 setup for static up right corner light: cascades fitted to
+    // the camera every frame, each kept across frames while nothing changes
+    // (ground, static, in a base map)
+    CascadedShadowMap cascades1;
+    cascades1.init(shadowSettings.settings().cascadeSize, shadowSettings.settings().depthFormat);
+    int  lastStationLod1[CascadedShadowMap::MAX_CASCADES] = { -1, -1, -1, -1 };   // station as last drawn into each cascade
+    bool lastStationInLight1[CascadedShadowMap::MAX_CASCADES] = {};
+    bool castersMoved1[CascadedShadowMap::MAX_CASCADES] = {};          // since the cascade was last drawn
     
     // Shadow map2 setup for dynamic shooting star light
     GLuint depthCubeFBO, depthCubeTex;
     glGenFramebuffers(1, &depthCubeFBO);
     glGenTextures(1, &depthCubeTex);
     glBindTexture(GL_TEXTURE_CUBE_MAP, depthCubeTex);
-    for (int i = 0; i < 6; ++i) {
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT,
-                    SHADOW_W, SHADOW_H, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
-    }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    // (re)allocates the faces; the FBO attachments stay valid
+    auto allocateShadowCube = [&](const ShadowTier& tier) {
+        glBindTexture(GL_TEXTURE_CUBE_MAP, depthCubeTex);
+        for (int i = 0; i < 6; ++i) {
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, (GLint)tier.depthFormat,
+                        tier.cubeSize, tier.cubeSize, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+        }
+    };
+    allocateShadowCube(shadowSettings.settings());
+    // depth compare in the sampler: each fetch is a bilinear 2x2 visibility (samplerCubeShadow)
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
@@ -582,25 +438,42 @@ int main() {
     glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthCubeTex, 0);
     glDrawBuffer(GL_NONE);
     glReadBuffer(GL_NONE);
+
+    // one face each, to clear only the faces a staggered update redraws
+    GLuint depthCubeFaceFBO[6];
+    glGenFramebuffers(6, depthCubeFaceFBO);
+    for (int i = 0; i < 6; ++i) {
+        glBindFramebuffer(GL_FRAMEBUFFER, depthCubeFaceFBO[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, depthCubeTex, 0);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+    }
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
 
     // Create shadow shader program for light 1
     GLuint shadowProgram = createShaderProgram("shaders/shadow_vertex.glsl", "shaders/shadow_fragment.glsl");
    
-    // Create point-light shadow (cubemap) program for light 2
-    GLuint pointShadowProgram = createShaderProgram("shaders/pointShadow_vertex.glsl", "shaders/pointShadow_fragment.glsl");
+    // Create point-light shadow (cubemap) program for light 2: all six faces in one pass
+    GLuint pointShadowProgram = createShaderProgram("shaders/pointShadow_vertex.glsl", "shaders/pointShadow_fragment.glsl",
+                                                    "shaders/pointShadow_geometry.glsl");
 
     // Create scene shader program
     GLuint sceneProgram = createShaderProgram("shaders/vertexShader.glsl", "shaders/fragmentShader.glsl");
     glUseProgram(sceneProgram);
 
+    // Skybox: full-screen triangle, plus the pass that turns galaxy.jpg into its cubemap
+    skybox.init(createShaderProgram("shaders/skybox_vertex.glsl", "shaders/skybox_fragment.glsl"),
+                createShaderProgram("shaders/skybox_vertex.glsl", "shaders/equirectToCube_fragment.glsl"));
+    glUseProgram(sceneProgram);
+
     // uniform declareation for sceneProgram
     const GLint uModel        = glGetUniformLocation(sceneProgram, "model");
     const GLint uView         = glGetUniformLocation(sceneProgram, "view");
     const GLint uProj         = glGetUniformLocation(sceneProgram, "projection");
     const GLint uUseLighting  = glGetUniformLocation(sceneProgram, "useLighting");
     const GLint uUseTexture   = glGetUniformLocation(sceneProgram, "useTexture");
+    const GLint uUseVirtualTexture = glGetUniformLocation(sceneProgram, "useVirtualTexture");
     const GLint uViewPos      = glGetUniformLocation(sceneProgram, "viewPos");
     const GLint uObjectColor  = glGetUniformLocation(sceneProgram, "objectColor");
 
@@ -609,8 +482,9 @@ int main() {
     const GLint uLightPos2    = glGetUniformLocation(sceneProgram, "lightPos2");
     const GLint uLightColor2  = glGetUniformLocation(sceneProgram, "lightColor2");
 
-    const GLint uLightSpace   = glGetUniformLocation(sceneProgram, "lightSpaceMatrix");
     const GLint uFarPlane2    = glGetUniformLocation(sceneProgram, "farPlane2");
+    const GLint uPcfTaps1     = glGetUniformLocation(sceneProgram, "pcfTaps1");
+    const GLint uPcfTaps2     = glGetUniformLocation(sceneProgram, "pcfTaps2");
 
     // Samplers
     const GLint uTex1         = glGetUniformLocation(sceneProgram, "texture1");
@@ -622,39 +496,49 @@ int main() {
     glUniform1i(uTex1,        0); // GL_TEXTURE0
     glUniform1i(uShadowMap,   1); // GL_TEXTURE1
     glUniform1i(uShadowCube2, 2); // GL_TEXTURE2
-
-    // Load the textures
-    GLuint sunTexture = loadTexture("texture/sun.jpg");
-    GLuint earthTexture = loadTexture("texture/earth.jpg");
-    GLuint marsTexture = loadTexture("texture/mars.jpg");
-    GLuint moonTexture = loadTexture("texture/moon.jpg");
-    GLuint galaxyTexture = loadTexture("texture/galaxy.jpg");
-
-    // Load the sphere model from OBJ file
-    if (!loadSphereModel("models/sphere.obj")) {
-        return -1; 
+    // GL_TEXTURE3/4: virtual texture indirection + atlas, set by VirtualTexture::bind
+    // GL_TEXTURE5: sphere texture array, set by SphereRenderer::init
+
+    // uniforms of pointShadowProgram (light 2 cube pass)
+    const GLint uFaceVP_PL    = glGetUniformLocation(pointShadowProgram, "faceVP");
+    const GLint uFaceMask_PL  = glGetUniformLocation(pointShadowProgram, "faceMask");
+    const GLint uModel_PL     = glGetUniformLocation(pointShadowProgram, "model");
+    const GLint uLightPos_PL  = glGetUniformLocation(pointShadowProgram, "lightPos");
+    const GLint uFarPlane_PL  = glGetUniformLocation(pointShadowProgram, "farPlane");
+
+    // Load the sphere and spacestation models (OBJ parsed once, then cached on disk)
+    if (const MeshHandle* m = meshCache.load("models/sphere.obj")) {
+        sphereMesh = *m;
+    } else {
+        return -1;
     }
-    // Loadd the spacestation model from OBJ file
-    if (!loadModelToBuffers("models/spacestation.obj", stationVAO, stationVBO, stationEBO, stationVertices, stationIndices)) {
+    if (const MeshHandle* m = meshCache.load("models/spacestation.obj")) {
+        stationMesh = *m;
+    } else {
         std::cerr << "Failed to load spacestation.obj\n";
     }
-    
-    // Fix station data if OBJ lacked normals/UVs or indices didn't align
-    bool needReupload = false;
-    if (!hasAnyNormals(stationVertices)) {
-        recomputeNormals(stationVertices, stationIndices);
-        needReupload = true;
-    }
-    if (!hasAnyUVs(stationVertices)) {
-        generateSphericalUVs(stationVertices);
-        needReupload = true;
-    }
-    if (needReupload) {
-        glBindBuffer(GL_ARRAY_BUFFER, stationVBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0,
-            stationVertices.size() * sizeof(Vertex), stationVertices.data());
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-    }
+
+    // Instanced spheres; each body map is copied into its layer once uploaded
+    sphereRenderer.init(meshCache, sphereMesh,
+                        createShaderProgram("shaders/skybox_vertex.glsl", "shaders/textureCopy_fragment.glsl"),
+                        BODY_LAYERS, { sceneProgram, shadowProgram, pointShadowProgram });
+    // Asteroid belt between the two planet orbits (Kepler periods scaled from Earth's)
+    GLuint asteroidProgram = createShaderProgram("shaders/asteroid_vertex.glsl", "shaders/asteroid_fragment.glsl");
+    const GLint uAstLightPos1   = glGetUniformLocation(asteroidProgram, "lightPos1");
+    const GLint uAstLightColor1 = glGetUniformLocation(asteroidProgram, "lightColor1");
+    const GLint uAstLightPos2   = glGetUniformLocation(asteroidProgram, "lightPos2");
+    const GLint uAstLightColor2 = glGetUniformLocation(asteroidProgram, "lightColor2");
+    asteroidBelt.innerRadius = PLANET_B_ORBIT_RADIUS + 0.4f;
+    asteroidBelt.outerRadius = PLANET_A_ORBIT_RADIUS - 0.4f;
+    asteroidBelt.referenceRadius = PLANET_A_ORBIT_RADIUS;
+    asteroidBelt.referencePeriod = EARTH_YEAR;
+    asteroidBelt.init(createFeedbackProgram("shaders/asteroidOrbit_vertex.glsl", "Center"), asteroidProgram, ASTEROID_COUNT);
+
+    struct BodyMap { TextureHandle* texture; int layer; };
+    BodyMap bodyMaps[] = {
+        { &sunTexture, LAYER_SUN }, { &earthTexture, LAYER_EARTH },
+        { &marsTexture, LAYER_MARS }, { &moonTexture, LAYER_MOON },
+    };
 
     //set up orbit traces ellipses? circles
     for (int i = 0; i <= ORBIT_SEGMENTS; ++i) {
@@ -750,54 +634,36 @@ int main() {
     );
     camera.resetMouse();
 
-    SceneNode* root = new SceneNode();  //identity node
-    SceneNode* galaxy = new SceneNode();
-    SceneNode* sun = new SceneNode();   //separate sun from identity
-    SceneNode* planetB = new SceneNode();
-    SceneNode* shootingStar = new SceneNode();
-    SceneNode* planetA_orbit = new SceneNode();
-    SceneNode* planetA_body = new SceneNode();
-    SceneNode* moon = new SceneNode();
-    SceneNode* station = new SceneNode();
+    // Scene hierarchy: flat transform arrays, parents before children
+    SceneGraph scene;
+    const SceneGraph::NodeId sun           = scene.create();
+    const SceneGraph::NodeId planetA_orbit = scene.create();
+    const SceneGraph::NodeId planetA_body  = scene.create(planetA_orbit);
+    const SceneGraph::NodeId moon          = scene.create(planetA_orbit);
+    const SceneGraph::NodeId station       = scene.create(planetA_body);  // attach to Earth
+    const SceneGraph::NodeId planetB       = scene.create();
+    const SceneGraph::NodeId shootingStar  = scene.create();
 
     // initial size + offset from Earth
-    station->localTransform =
+    scene.setLocal(station,
         glm::translate(glm::mat4(1.0f), glm::vec3(2.0f, 0.0f, 0.0f)) *
-        glm::scale(glm::mat4(1.0f), glm::vec3(0.05f));
-
-    root->addChild(sun);
-    root->addChild(galaxy);
-    root->addChild(planetA_orbit);
-    planetA_orbit ->addChild(planetA_body);
-    planetA_orbit ->addChild(moon);
-    planetA_body ->addChild(station);  // attach to Earth
-    root->addChild(planetB);
-    root->addChild(shootingStar);
-
-
-    // Now modelLoc is valid here:
-    //root->drawFunc = [&](const glm::mat4& model) {
-    //glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-    // drawSphere();
-
-    sun->drawFunc = [&](const glm::mat4& model) {
-        glUseProgram(sceneProgram);
-        glUniform1i(uUseLighting, 0);   // light source, no lighting
-        glUniform1i(uUseTexture,  1);
-        glUniform1i(uReceiveShadows, 0);    // do not receive shadows
-        glUniform3f(uObjectColor, 1.0f, 1.0f, 1.0f);      // reset tint
-        glUniformMatrix4fv(uModel, 1, GL_FALSE, glm::value_ptr(model));
-
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, sunTexture);
-
-        glBindVertexArray(sphereVAO);
-        glDrawElements(GL_TRIANGLES, sphereIndices.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-    };
-
-
-    planetA_body->drawFunc = [&](const glm::mat4& model) {
+        glm::scale(glm::mat4(1.0f), glm::vec3(0.05f)));
+
+    // culling bounds: the meshes' bounding spheres, scaled by the world transforms
+    for (SceneGraph::NodeId body : { sun, planetA_body, planetB, moon, shootingStar })
+        scene.setBounds(body, sphereMesh.center, sphereMesh.radius);
+    scene.setBounds(station, stationMesh.center, stationMesh.radius);
+    BoundingSphere groundBounds;    // 200 x 200 quad at y = -1
+    groundBounds.center = glm::vec3(0.0f, -1.0f, 0.0f);
+    groundBounds.radius = 100.0f * 1.4143f;
+
+    // Draw list kinds: one draw function per kind, called with each listed node's world matrix
+    enum SceneDraw { DRAW_EARTH_VT, DRAW_MARS_VT, DRAW_MOON_VT, DRAW_STATION, DRAW_KINDS };
+    std::function<void(const glm::mat4&)> drawFuncs[DRAW_KINDS];
+
+    // sun, shooting star and planets without a virtual texture are not on
+    // the draw list: sphereRenderer draws them from the per-frame instance list
+    drawFuncs[DRAW_EARTH_VT] = [&](const glm::mat4& model) {
         glUseProgram(sceneProgram);
         glUniform1i(uUseLighting, 1);
         glUniform1i(uUseTexture,  1);
@@ -805,15 +671,15 @@ int main() {
         glUniform3f(uObjectColor, 1.0f, 1.0f, 1.0f);      // reset tint
         glUniformMatrix4fv(uModel, 1, GL_FALSE, glm::value_ptr(model));
 
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, earthTexture);
+        earthVT.bind(sceneProgram, 3, 4);
 
-        glBindVertexArray(sphereVAO);
-        glDrawElements(GL_TRIANGLES, sphereIndices.size(), GL_UNSIGNED_INT, 0);
+        meshCache.bind();
+        sphereMesh.draw(sphereMesh.selectLod(model, lodView));
         glBindVertexArray(0);
+        glUniform1i(uUseVirtualTexture, 0);
     };
 
-    planetB->drawFunc = [&](const glm::mat4& model) {
+    drawFuncs[DRAW_MARS_VT] = [&](const glm::mat4& model) {
         glUseProgram(sceneProgram);
         glUniform1i(uUseLighting, 1);
         glUniform1i(uUseTexture,  1);
@@ -821,29 +687,15 @@ int main() {
         glUniform3f(uObjectColor, 1.0f, 1.0f, 1.0f);      // reset tint
         glUniformMatrix4fv(uModel, 1, GL_FALSE, glm::value_ptr(model));
 
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, marsTexture);
+        marsVT.bind(sceneProgram, 3, 4);
 
-        glBindVertexArray(sphereVAO);
-        glDrawElements(GL_TRIANGLES, sphereIndices.size(), GL_UNSIGNED_INT, 0);
+        meshCache.bind();
+        sphereMesh.draw(sphereMesh.selectLod(model, lodView));
         glBindVertexArray(0);
+        glUniform1i(uUseVirtualTexture, 0);
     };
 
-    shootingStar->drawFunc = [&](const glm::mat4& model) {
-        glUseProgram(sceneProgram);
-        glUniform1i(uUseLighting, 0); // light source, no lighting
-        glUniform1i(uReceiveShadows, 0); // do not receive shadows
-        glUniform1i(uUseTexture,  0);
-        glUniform3f(uObjectColor, 1.0f, 1.0f, 1.0f);      // reset tint
-        glUniformMatrix4fv(uModel, 1, GL_FALSE, glm::value_ptr(model));
-        glUniform3f(uObjectColor, 1.0f, 1.0f, 1.0f);
-
-        glBindVertexArray(sphereVAO);
-        glDrawElements(GL_TRIANGLES, sphereIndices.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-    };
-
-    moon->drawFunc = [&](const glm::mat4& model) {
+    drawFuncs[DRAW_MOON_VT] = [&](const glm::mat4& model) {
         glUseProgram(sceneProgram);
         glUniform1i(uUseLighting, 1);
         glUniform1i(uUseTexture,  1);
@@ -851,15 +703,15 @@ int main() {
         glUniform3f(uObjectColor, 1.0f, 1.0f, 1.0f);      // reset tint
         glUniformMatrix4fv(uModel, 1, GL_FALSE, glm::value_ptr(model));
 
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, moonTexture);
+        moonVT.bind(sceneProgram, 3, 4);
 
-        glBindVertexArray(sphereVAO);
-        glDrawElements(GL_TRIANGLES, sphereIndices.size(), GL_UNSIGNED_INT, 0);
+        meshCache.bind();
+        sphereMesh.draw(sphereMesh.selectLod(model, lodView));
         glBindVertexArray(0);
+        glUniform1i(uUseVirtualTexture, 0);
     };
 
-    station->drawFunc = [&](const glm::mat4& model){
+    drawFuncs[DRAW_STATION] = [&](const glm::mat4& model){
         glUseProgram(sceneProgram);
         glUniform1i(uUseLighting, 1);
         glUniform1i(uUseTexture,  0); //no texture
@@ -872,11 +724,16 @@ int main() {
         glUniform3f(uObjectColor, color.x, color.y, color.z);
 
         // do NOT bind stationTexture anymore
-        glBindVertexArray(stationVAO);
-        glDrawElements(GL_TRIANGLES, (GLsizei)stationIndices.size(), GL_UNSIGNED_INT, 0);
+        meshCache.bind();
+        stationMesh.draw(stationMesh.selectLod(model, lodView));
         glBindVertexArray(0);
     };
 
+    if (earthVT.isOpen()) scene.addDraw(planetA_body, DRAW_EARTH_VT);
+    if (marsVT.isOpen())  scene.addDraw(planetB, DRAW_MARS_VT);
+    if (moonVT.isOpen())  scene.addDraw(moon, DRAW_MOON_VT);
+    scene.addDraw(station, DRAW_STATION);
+
     // Time control factor
     float timeScale = 0.2f;
     float deltaTime = 0.0f;
@@ -889,6 +746,17 @@ int main() {
         int fbw = 0, fbh = 0;   //later use for view/proj
 
         glfwPollEvents();
+        // upload any textures that finished decoding; report memory once the queue drains
+        if (textureLoader.poll() && textureLoader.pending() == 0)
+            printTextureStats();
+        // the equirect galaxy is only needed to build the cubemap
+        if (galaxyTexture && textureLoader.isUploaded(galaxyTexture.id()) && skybox.buildFromEquirect(galaxyTexture.id()))
+            galaxyTexture.reset();
+        // likewise the body maps once they are in the sphere texture array
+        for (BodyMap& map : bodyMaps)
+            if (*map.texture && textureLoader.isUploaded(map.texture->id()) &&
+                sphereRenderer.setLayer(map.layer, map.texture->id()))
+                map.texture->reset();
         if (appMode != lastAppMode) {
             camera.resetMouse();
             lastAppMode = appMode;
@@ -917,33 +785,12 @@ int main() {
             glm::vec3 camPosM = camera.getPosition();
             glUniform3f(uViewPos, camPosM.x, camPosM.y, camPosM.z);
 
-            {
-                glm::mat4 galaxyTransform =
-                    glm::scale(glm::translate(glm::mat4(1.0f), camera.getPosition()), glm::vec3(50.0f));
-
-                glDisable(GL_DEPTH_TEST);
-
-                // If the texture is valid, render inside-out sphere.
-                if (galaxyTexture) {
-                    glCullFace(GL_FRONT);
-                    glUseProgram(sceneProgram);
-                    glUniform1i(uUseLighting, 0);
-                    glUniform1i(uUseTexture,  1);
-                    glUniform1i(uReceiveShadows, 0);
-                    glUniform3f(uObjectColor, 1,1,1);
-                    glUniformMatrix4fv(uModel, 1, GL_FALSE, glm::value_ptr(galaxyTransform));
-                    glActiveTexture(GL_TEXTURE0);
-                    glBindTexture(GL_TEXTURE_2D, galaxyTexture);
-                    glBindVertexArray(sphereVAO);
-                    glDrawElements(GL_TRIANGLES, (GLsizei)sphereIndices.size(), GL_UNSIGNED_INT, 0);
-                    glBindVertexArray(0);
-                    glCullFace(GL_BACK);
-                } else {
-                    // Fallback: just clear to a darker color
-                    glClearColor(0.03f, 0.03f, 0.05f, 1.0f);
-                    glClear(GL_COLOR_BUFFER_BIT);
-                }
-                glEnable(GL_DEPTH_TEST);
+            if (skybox.ready()) {
+                skybox.draw(viewM, projM);
+            } else {
+                // Fallback: just clear to a darker color
+                glClearColor(0.03f, 0.03f, 0.05f, 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT);
             }
 
             // Two centered buttons (top = VIEW MODE, bottom = GAME MODE)
@@ -1062,6 +909,25 @@ int main() {
         }
         lPressedLast = lNow;
 
+        // shadow quality: LOW, MEDIUM, HIGH, ULTRA, auto
+        bool oNow = glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS;
+        if (oNow && !oPressedLastFrame) {
+            shadowSettings.cycle();
+            if (shadowSettings.isAuto())
+                std::cout << "Shadows: auto (" << shadowSettings.settings().name << ")" << std::endl;
+        }
+        oPressedLastFrame = oNow;
+
+        // new tier: recreate the maps, then every map is redrawn this frame
+        shadowSettings.beginFrame();
+        if (shadowSettings.takeChanged()) {
+            const ShadowTier& tier = shadowSettings.settings();
+            cascades1.init(tier.cascadeSize, tier.depthFormat);
+            allocateShadowCube(tier);
+            std::cout << "Shadows: " << tier.name << (shadowSettings.isAuto() ? " (auto)" : "") << std::endl;
+        }
+        const ShadowTier& shadowTier = shadowSettings.settings();
+
 
         // Create transformation matrices
         glm::mat4 model = glm::mat4(1.0f);
@@ -1081,52 +947,151 @@ int main() {
         // Update camera/view uniforms
         glm::vec3 camPos = camera.getPosition();
         glUniform3f(uViewPos, camPos.x, camPos.y, camPos.z);
-
-        // update galaxy transform every frame so it follows camera
-        galaxy->localTransform = glm::scale(glm::translate(glm::mat4(1.0f), camera.getPosition()), glm::vec3(50.0f));
+        lodView.set(camPos, glm::radians(45.0f), fbh);
 
         // Light 1: static top-right corner -ish
         glm::vec3 lightPos1 = glm::vec3(10.0f, 10.0f, 10.0f);
         glm::vec3 lightColor1 = glm::vec3(1.0f);
-
-        // Light 2: dynamic shooting star across the sky, single direction shooting, loop periodically
-        float angle = simTime * 0.5f;
-        glm::vec3 lightPos2 = glm::vec3(0.0f , 8.0f * cos(angle), 8.0f * sin(angle));
         glm::vec3 lightColor2 = glm::vec3(1.0f, 1.0f, 1.0f);  // shooting star bright full white for better seeing in testing
 
-        // build light-space matrix for light 1 shadow (from lightPos1 toward origin)
-        glm::mat4 lightProj = glm::ortho(-30.0f, 30.0f, -30.0f, 30.0f, 0.1f, 60.0f);
-        glm::mat4 lightView = glm::lookAt(lightPos1, glm::vec3(0,0,0), glm::vec3(0,1,0));
-        glm::mat4 lightSpaceMatrix = lightProj * lightView;
-
         // light 2 shadow setup 
         float nearPL = 0.1f, farPL = 100.0f; 
         glm::mat4 shadowProj2 = glm::perspective(glm::radians(90.0f), 1.0f, nearPL, farPL);
-        glm::vec3 lp = lightPos2;
-        glm::mat4 views2[6] = {
-            glm::lookAt(lp, lp + glm::vec3( 1, 0, 0), glm::vec3(0,-1, 0)), // +X
-            glm::lookAt(lp, lp + glm::vec3(-1, 0, 0), glm::vec3(0,-1, 0)), // -X
-            glm::lookAt(lp, lp + glm::vec3( 0, 1, 0), glm::vec3(0, 0, 1)), // +Y
-            glm::lookAt(lp, lp + glm::vec3( 0,-1, 0), glm::vec3(0, 0,-1)), // -Y
-            glm::lookAt(lp, lp + glm::vec3( 0, 0, 1), glm::vec3(0,-1, 0)), // +Z
-            glm::lookAt(lp, lp + glm::vec3( 0, 0,-1), glm::vec3(0,-1, 0))  // -Z
-        };
 
-        //Animate Orbit Around Earth
-        float r = 2.0f, w = glm::radians(10.0f), t = glfwGetTime();
-        station->localTransform =
-        glm::translate(glm::mat4(1.0f), glm::vec3(cos(t*w)*r, 0.0f, sin(t*w)*r)) *
-        glm::scale(glm::mat4(1.0f), glm::vec3(0.025f));
-
-        // Update shooting star's transform
-        glm::mat4 starTransform = glm::translate(glm::mat4(1.0f), lightPos2);
-        starTransform = glm::scale(starTransform, glm::vec3(0.1f));
-        shootingStar->localTransform = starTransform;
-        
-        // Update trail positions
-        trailPositions.push_back(lightPos2);
-        if (trailPositions.size() > TRAIL_LENGTH)
-            trailPositions.erase(trailPositions.begin());
+        // Written by the frame graph tasks below
+        glm::vec3 lightPos2, lp;
+        glm::mat4 views2[6], faceVP2[6];
+        Frustum passFrustums[CULL_PASSES], faceFrustums2[6];
+        CullStats frameCull[CULL_PASSES];
+        passFrustums[CULL_CAMERA].set(projection * view);
+        float simDays = 0.0f, earthOrbitAngle = 0.0f, marsOrbitAngle = 0.0f;
+        int stationLod = 0;
+        const float t = glfwGetTime();
+
+        // Per-frame CPU work as a frame graph: each task names what it reads
+        // and writes, and tasks whose inputs are ready run in parallel on the
+        // job system. No GL in here; this thread submits once run() returns.
+        frameGraph.clear();
+        frameGraph.add("lights", { "clock" }, { "lights" }, [&] {
+            // Light 2: dynamic shooting star across the sky, single direction shooting, loop periodically
+            float angle = simTime * 0.5f;
+            lightPos2 = glm::vec3(0.0f , 8.0f * cos(angle), 8.0f * sin(angle));
+
+            // light 1 shadow cascades, fitted to the camera (light from lightPos1 toward origin)
+            cascades1.fit(view, glm::radians(45.0f), aspect, 0.1f, -lightPos1,
+                          shadowSettings.cascadeMask(cascades1.cascadeCount));
+
+            lp = lightPos2;
+            views2[0] = glm::lookAt(lp, lp + glm::vec3( 1, 0, 0), glm::vec3(0,-1, 0)); // +X
+            views2[1] = glm::lookAt(lp, lp + glm::vec3(-1, 0, 0), glm::vec3(0,-1, 0)); // -X
+            views2[2] = glm::lookAt(lp, lp + glm::vec3( 0, 1, 0), glm::vec3(0, 0, 1)); // +Y
+            views2[3] = glm::lookAt(lp, lp + glm::vec3( 0,-1, 0), glm::vec3(0, 0,-1)); // -Y
+            views2[4] = glm::lookAt(lp, lp + glm::vec3( 0, 0, 1), glm::vec3(0,-1, 0)); // +Z
+            views2[5] = glm::lookAt(lp, lp + glm::vec3( 0, 0,-1), glm::vec3(0,-1, 0)); // -Z
+
+            for (int c = 0; c < CascadedShadowMap::MAX_CASCADES; ++c)
+                passFrustums[CULL_CASCADE + c].set(cascades1.matrix(c));
+            for (int face = 0; face < 6; ++face) {
+                faceVP2[face] = shadowProj2 * views2[face];
+                faceFrustums2[face].set(faceVP2[face]);
+            }
+            // the six faces together cover the cube of half-size farPL around the light
+            passFrustums[CULL_LIGHT2].set(glm::ortho(-farPL, farPL, -farPL, farPL, -farPL, farPL) *
+                                          glm::translate(glm::mat4(1.0f), -lp));
+        });
+
+        frameGraph.add("trail", { "lights" }, { "trail" }, [&] {
+            // Update trail positions
+            trailPositions.push_back(lightPos2);
+            if (trailPositions.size() > TRAIL_LENGTH)
+                trailPositions.erase(trailPositions.begin());
+        });
+
+        frameGraph.add("animation", { "lights" }, { "clock", "locals" }, [&] {
+            //Animate Orbit Around Earth
+            float r = 2.0f, w = glm::radians(10.0f);
+            scene.setLocal(station,
+            glm::translate(glm::mat4(1.0f), glm::vec3(cos(t*w)*r, 0.0f, sin(t*w)*r)) *
+            glm::scale(glm::mat4(1.0f), glm::vec3(0.025f)));
+
+            // Update shooting star's transform
+            glm::mat4 starTransform = glm::translate(glm::mat4(1.0f), lightPos2);
+            starTransform = glm::scale(starTransform, glm::vec3(0.1f));
+            scene.setLocal(shootingStar, starTransform);
+
+            // Yibo Tang: Update transforms (hierarchical scene graph)
+            simTime       += deltaTime * timeSpeed;
+            simDays = simTime * DAYS_PER_SECOND;
+
+            // Sun self-rotation (25 days per rotation)
+            float sunAngle = simDays / SUN_DAY * glm::two_pi<float>();
+            scene.setLocal(sun,
+                glm::rotate(glm::mat4(1.0f), sunAngle, glm::vec3(0,1,0))
+            * glm::scale(glm::mat4(1.0f), glm::vec3(1.5f)));
+
+            // Earth orbit + spin
+            earthOrbitAngle = simDays / EARTH_YEAR * glm::two_pi<float>();
+            scene.setLocal(planetA_orbit,
+                glm::rotate(glm::mat4(1.0f), earthOrbitAngle, glm::vec3(0,1,0))
+            * glm::translate(glm::mat4(1.0f), glm::vec3(PLANET_A_ORBIT_RADIUS,0,0)));
+
+            float earthSpinAngle = simDays / EARTH_DAY * glm::two_pi<float>();
+
+            scene.setLocal(planetA_body,
+                glm::rotate(glm::mat4(1.0f), earthSpinAngle, glm::vec3(0,1,0)));
+
+            // Mars orbit + spin
+            marsOrbitAngle = simDays / MARS_YEAR * glm::two_pi<float>();
+            float marsSpinAngle  = simDays / MARS_DAY  * glm::two_pi<float>();   
+
+            scene.setLocal(planetB,
+                glm::rotate(glm::mat4(1.0f), marsOrbitAngle, glm::vec3(0,1,0))
+                * glm::translate(glm::mat4(1.0f), glm::vec3(PLANET_B_ORBIT_RADIUS,0,0))
+                * glm::rotate(glm::mat4(1.0f), marsSpinAngle,  glm::vec3(0,1,0))
+                * glm::scale(glm::mat4(1.0f), glm::vec3(0.4f)));
+
+            // Moon orbit around Earth
+            float moonOrbitAngle = simDays / MOON_MONTH * glm::two_pi<float>();
+            scene.setLocal(moon,
+                glm::rotate(glm::mat4(1.0f), moonOrbitAngle, glm::vec3(0, 1, 0)) *
+                glm::translate(glm::mat4(1.0f), glm::vec3(MOON_ORBIT_RADIUS, 0, 0)) *
+                glm::rotate(glm::mat4(1.0f), moonOrbitAngle, glm::vec3(0, 1, 0)) *
+                glm::scale(glm::mat4(1.0f), glm::vec3(0.5f)));
+        });
+
+        // World transforms once per frame: only nodes whose local changed and
+        // their subtrees are recomputed (nothing while the sim is paused), and
+        // the shadow passes, picking and draws all read the cached worlds
+        frameGraph.add("transforms", { "locals" }, { "worlds" }, [&] {
+            scene.update(jobs);
+        });
+
+        // Every sphere of the frame, for the shadow passes and the colour pass.
+        // Planets with a virtual texture cast shadows from here but draw
+        // themselves (draw list) in the colour pass. Each pass keeps only the
+        // spheres inside its frustum.
+        frameGraph.add("instances", { "worlds", "lights" }, { "instances" }, [&] {
+            // LODs picked from the camera; the shadow passes reuse them so casters
+            // match the surfaces that receive their shadows
+            stationLod = stationMesh.selectLod(scene.world(station), lodView);
+
+            const uint32_t planetFlags = SphereRenderer::LIT | SphereRenderer::TEXTURED |
+                                         SphereRenderer::RECEIVES_SHADOWS | SphereRenderer::CASTS_SHADOWS;
+            auto vtFlags = [](const VirtualTexture& vt) { return vt.isOpen() ? (uint32_t)SphereRenderer::SHADOW_ONLY : 0u; };
+            sphereRenderer.clear();
+            sphereRenderer.add({ scene.world(sun), glm::vec4(1.0f), LAYER_SUN,
+                                 SphereRenderer::TEXTURED | SphereRenderer::CASTS_SHADOWS });   // light source, unlit
+            sphereRenderer.add({ scene.world(planetA_body), glm::vec4(1.0f), LAYER_EARTH, planetFlags | vtFlags(earthVT) });
+            sphereRenderer.add({ scene.world(planetB), glm::vec4(1.0f), LAYER_MARS, planetFlags | vtFlags(marsVT) });
+            sphereRenderer.add({ scene.world(moon), glm::vec4(1.0f), LAYER_MOON, planetFlags | vtFlags(moonVT) });
+            sphereRenderer.add({ scene.world(shootingStar), glm::vec4(1.0f), 0, 0 });  // light source: plain white
+            sphereRenderer.build(lodView, CULL_PASSES, passFrustums, frameCull);
+        });
+
+        frameGraph.run(jobs);
+        gpuFrameTimer.begin();
+        const glm::mat4& earthGlobal = scene.world(planetA_body);
+        const glm::mat4& moonGlobal  = scene.world(moon);
 
         glBindBuffer(GL_ARRAY_BUFFER, trailVBO);
         glBufferSubData(GL_ARRAY_BUFFER, 0, trailPositions.size() * sizeof(glm::vec3), trailPositions.data());
@@ -1146,157 +1111,153 @@ int main() {
         //glDrawElements(GL_TRIANGLES, sphereIndices.size(), GL_UNSIGNED_INT, 0);
         //glBindVertexArray(0);
 
-        // Yibo Tang: Update transforms (hierarchical scene graph)
-        simTime       += deltaTime * timeSpeed;
-        float simDays = simTime * DAYS_PER_SECOND;
-
-        // Sun self-rotation (25 days per rotation)
-        float sunAngle = simDays / SUN_DAY * glm::two_pi<float>();
-        sun->localTransform =
-            glm::rotate(glm::mat4(1.0f), sunAngle, glm::vec3(0,1,0))
-        * glm::scale(glm::mat4(1.0f), glm::vec3(1.5f));
-
-        // Earth orbit + spin
-        float earthOrbitAngle = simDays / EARTH_YEAR * glm::two_pi<float>();
-        planetA_orbit->localTransform =
-            glm::rotate(glm::mat4(1.0f), earthOrbitAngle, glm::vec3(0,1,0))
-        * glm::translate(glm::mat4(1.0f), glm::vec3(PLANET_A_ORBIT_RADIUS,0,0));
-
-        float earthSpinAngle = simDays / EARTH_DAY * glm::two_pi<float>();
-
-        planetA_body->localTransform =
-            glm::rotate(glm::mat4(1.0f), earthSpinAngle, glm::vec3(0,1,0));
-
-        // Mars orbit + spin
-        float marsOrbitAngle = simDays / MARS_YEAR * glm::two_pi<float>();
-        float marsSpinAngle  = simDays / MARS_DAY  * glm::two_pi<float>();   
-
-        planetB->localTransform =
-            glm::rotate(glm::mat4(1.0f), marsOrbitAngle, glm::vec3(0,1,0))
-            * glm::translate(glm::mat4(1.0f), glm::vec3(PLANET_B_ORBIT_RADIUS,0,0))
-            * glm::rotate(glm::mat4(1.0f), marsSpinAngle,  glm::vec3(0,1,0))
-            * glm::scale(glm::mat4(1.0f), glm::vec3(0.4f));
-
-        // Moon orbit around Earth
-        float moonOrbitAngle = simDays / MOON_MONTH * glm::two_pi<float>();
-        moon->localTransform =
-            glm::rotate(glm::mat4(1.0f), moonOrbitAngle, glm::vec3(0, 1, 0)) *
-            glm::translate(glm::mat4(1.0f), glm::vec3(MOON_ORBIT_RADIUS, 0, 0)) *
-            glm::rotate(glm::mat4(1.0f), moonOrbitAngle, glm::vec3(0, 1, 0)) *
-            glm::scale(glm::mat4(1.0f), glm::vec3(0.5f));
-
-        // Compute globals once per frame (after local transforms are updated)
-        glm::mat4 earthGlobal = planetA_orbit->getGlobalTransform() * planetA_body->localTransform;
-        glm::mat4 moonGlobal  = moon->getGlobalTransform(planetA_orbit->getGlobalTransform());
-
-        // SHADOW DEPTH PASS: LIGHT 1
-        glViewport(0, 0, SHADOW_W, SHADOW_H);
-        glBindFramebuffer(GL_FRAMEBUFFER, depthFBO);
-        glClear(GL_DEPTH_BUFFER_BIT);
+        sphereRenderer.upload();
+
+        // Asteroid positions, culling and LOD bands for this frame, all on the GPU
+        asteroidBelt.update(simDays, view, projection, lodView);
+
+        // Streamed planet maps: pages this view needs, then upload what the reader has finished
+        earthVT.beginFrame();
+        earthVT.requestSphere(earthGlobal, sphereMesh.center, sphereMesh.radius, lodView);
+        earthVT.update();
+        marsVT.beginFrame();
+        marsVT.requestSphere(scene.world(planetB), sphereMesh.center, sphereMesh.radius, lodView);
+        marsVT.update();
+        moonVT.beginFrame();
+        moonVT.requestSphere(moonGlobal, sphereMesh.center, sphereMesh.radius, lodView);
+        moonVT.update();
+
+        // SHADOW DEPTH PASS: LIGHT 1, one cascade at a time
+        // Each cascade is cached: skipped while neither its matrix (the camera)
+        // nor a caster in it changed (paused sim, menus), and the ground is
+        // only redrawn when the matrix moves.
+        glViewport(0, 0, cascades1.size(), cascades1.size());
         glUseProgram(shadowProgram);
 
         glEnable(GL_POLYGON_OFFSET_FILL);
         glPolygonOffset(1.5f, 3.0f);
 
-        glUniformMatrix4fv(glGetUniformLocation(shadowProgram, "lightSpaceMatrix"), 1, GL_FALSE, glm::value_ptr(lightSpaceMatrix));
+        GLint  uLightSpaceShadow = glGetUniformLocation(shadowProgram, "lightSpaceMatrix");
         GLuint modelLocShadow = glGetUniformLocation(shadowProgram, "model");
 
         glCullFace(GL_FRONT); // reduce acne
 
-        // Sun
-        glUniformMatrix4fv(modelLocShadow, 1, GL_FALSE, glm::value_ptr(sun->getGlobalTransform()));
-        glBindVertexArray(sphereVAO);
-        glDrawElements(GL_TRIANGLES, (GLsizei)sphereIndices.size(), GL_UNSIGNED_INT, 0);
-
-        // Earth
-        glUniformMatrix4fv(modelLocShadow, 1, GL_FALSE, glm::value_ptr(earthGlobal));
-        glDrawElements(GL_TRIANGLES, (GLsizei)sphereIndices.size(), GL_UNSIGNED_INT, 0);
-
-        // Mars
-        glUniformMatrix4fv(modelLocShadow, 1, GL_FALSE, glm::value_ptr(planetB->getGlobalTransform()));
-        glDrawElements(GL_TRIANGLES, (GLsizei)sphereIndices.size(), GL_UNSIGNED_INT, 0);
-
-        // Moon
-        glUniformMatrix4fv(modelLocShadow, 1, GL_FALSE, glm::value_ptr(moonGlobal));
-        glDrawElements(GL_TRIANGLES, (GLsizei)sphereIndices.size(), GL_UNSIGNED_INT, 0);
-
-        // Space station shadow
-        glUniformMatrix4fv(modelLocShadow, 1, GL_FALSE, glm::value_ptr(station->getGlobalTransform()));
-        glBindVertexArray(stationVAO);
-        glDrawElements(GL_TRIANGLES, (GLsizei)stationIndices.size(), GL_UNSIGNED_INT, 0);
-        
-        //ground
-        if (!renderGalaxy) {
-            glm::mat4 M = glm::mat4(1.0f);
-            glUniformMatrix4fv(modelLocShadow, 1, GL_FALSE, glm::value_ptr(M));
-            glBindVertexArray(groundVAO);
-            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+        for (int c = 0; c < cascades1.cascadeCount; ++c) {
+            const int pass = CULL_CASCADE + c;
+            castersMoved1[c] = castersMoved1[c] || sphereRenderer.changed(pass) || scene.changed(station);
+            if (!shadowSettings.cascadeDue(c)) continue;   // keeps its map and matrix
+            bool stationIn = frameCull[pass].count(passFrustums[pass].intersects(scene.bounds(station)));
+            bool groundIn  = !renderGalaxy && frameCull[pass].count(passFrustums[pass].intersects(groundBounds));
+            bool castersChanged = castersMoved1[c] ||
+                                  stationIn != lastStationInLight1[c] ||
+                                  (stationIn && stationLod != lastStationLod1[c]);
+            castersMoved1[c] = false;
+            lastStationInLight1[c] = stationIn;
+            lastStationLod1[c] = stationLod;
+
+            ShadowCache& cache = cascades1.cache(c);
+            ShadowCache::Redraw redraw = cache.begin(cascades1.matrix(c), groundIn ? 1u : 0u, castersChanged);
+            if (redraw == ShadowCache::NOTHING) continue;
+
+            glUniformMatrix4fv(uLightSpaceShadow, 1, GL_FALSE, glm::value_ptr(cascades1.matrix(c)));
+
+            // Static casters into the base map: ground
+            if (redraw == ShadowCache::ALL) {
+                cache.bindBase();
+                if (groundIn) {
+                    glm::mat4 M = glm::mat4(1.0f);
+                    glUniformMatrix4fv(modelLocShadow, 1, GL_FALSE, glm::value_ptr(M));
+                    glBindVertexArray(groundVAO);
+                    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+                }
+            }
+
+            // Dynamic casters over a copy of it, into the cascade's layer
+            cache.bindDynamic();
+
+            // Sun, Earth, Mars, Moon: instanced, position stream only
+            sphereRenderer.drawDepth(shadowProgram, pass);
+
+            // Space station shadow
+            if (stationIn) {
+                glUniformMatrix4fv(modelLocShadow, 1, GL_FALSE, glm::value_ptr(scene.world(station)));
+                meshCache.bindDepthOnly(); // position stream only
+                stationMesh.draw(stationLod);
+            }
         }
-        
+
         glDisable(GL_POLYGON_OFFSET_FILL);
 
         glBindVertexArray(0);
         glBindFramebuffer(GL_FRAMEBUFFER, 0); 
 
         // SHADOW DEPTH PASS: LIGHT 2 (shooting star)
-        glViewport(0, 0, SHADOW_W, SHADOW_H);
-        glBindFramebuffer(GL_FRAMEBUFFER, depthCubeFBO);
-        glUseProgram(pointShadowProgram);
-
-        GLint uVP_PL       = glGetUniformLocation(pointShadowProgram, "vp");
-        GLint uModel_PL    = glGetUniformLocation(pointShadowProgram, "model");
-        GLint uLightPos_PL = glGetUniformLocation(pointShadowProgram, "lightPos");
-        GLint uFarPlane_PL = glGetUniformLocation(pointShadowProgram, "farPlane");
-
-        glUniform3fv(uLightPos_PL, 1, glm::value_ptr(lp));
-        glUniform1f(uFarPlane_PL, farPL);
-
-        glDisable(GL_CULL_FACE);
-        glEnable(GL_DEPTH_TEST);
-
-        for (int face = 0; face < 6; ++face) {
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
-                                GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, depthCubeTex, 0);
-            glClear(GL_DEPTH_BUFFER_BIT);
-
-            glm::mat4 vp = shadowProj2 * views2[face];
-            glUniformMatrix4fv(uVP_PL, 1, GL_FALSE, glm::value_ptr(vp));
-
-            // Sun
-            glUniformMatrix4fv(uModel_PL, 1, GL_FALSE, glm::value_ptr(sun->getGlobalTransform()));
-            glBindVertexArray(sphereVAO);
-            glDrawElements(GL_TRIANGLES, (GLsizei)sphereIndices.size(), GL_UNSIGNED_INT, 0);
+        // One layered pass: depthCubeTex is attached whole, and the geometry
+        // shader sends every triangle to the faces (layers) it falls in, so
+        // each object is submitted once instead of once per face. Lower tiers
+        // redraw only some faces per frame (cubeFaces); the rest keep theirs.
+        const int cubeFaces = shadowSettings.cubeFacesDue();
+        if (cubeFaces != 0) {
+            glViewport(0, 0, shadowTier.cubeSize, shadowTier.cubeSize);
+            if (cubeFaces == 0x3f) {
+                glBindFramebuffer(GL_FRAMEBUFFER, depthCubeFBO);
+                glClear(GL_DEPTH_BUFFER_BIT);   // all six layers
+            } else {
+                for (int face = 0; face < 6; ++face) {
+                    if (!(cubeFaces & (1 << face))) continue;
+                    glBindFramebuffer(GL_FRAMEBUFFER, depthCubeFaceFBO[face]);
+                    glClear(GL_DEPTH_BUFFER_BIT);
+                }
+                glBindFramebuffer(GL_FRAMEBUFFER, depthCubeFBO);
+            }
+            glUseProgram(pointShadowProgram);
+            glUniformMatrix4fv(uFaceVP_PL, 6, GL_FALSE, glm::value_ptr(faceVP2[0]));
+            glUniform3fv(uLightPos_PL, 1, glm::value_ptr(lp));
+            glUniform1f(uFarPlane_PL, farPL);
 
-            // Earth
-            glUniformMatrix4fv(uModel_PL, 1, GL_FALSE, glm::value_ptr(earthGlobal));
-            glDrawElements(GL_TRIANGLES, (GLsizei)sphereIndices.size(), GL_UNSIGNED_INT, 0);
+            glDisable(GL_CULL_FACE);
+            glEnable(GL_DEPTH_TEST);
 
-            // Mars
-            glUniformMatrix4fv(uModel_PL, 1, GL_FALSE, glm::value_ptr(planetB->getGlobalTransform()));
-            glDrawElements(GL_TRIANGLES, (GLsizei)sphereIndices.size(), GL_UNSIGNED_INT, 0);
+            // Faces being redrawn whose frustum a bounding sphere reaches, one bit each
+            auto cubeFaceMask = [&](const BoundingSphere& b) {
+                int mask = 0;
+                for (int face = 0; face < 6; ++face)
+                    if ((cubeFaces & (1 << face)) && faceFrustums2[face].intersects(b)) mask |= 1 << face;
+                return mask;
+            };
 
-            // Moon
-            glUniformMatrix4fv(uModel_PL, 1, GL_FALSE, glm::value_ptr(moonGlobal));
-            glDrawElements(GL_TRIANGLES, (GLsizei)sphereIndices.size(), GL_UNSIGNED_INT, 0);
+            // Sun, Earth, Mars, Moon: instanced; the geometry shader culls per face
+            glUniform1i(uFaceMask_PL, cubeFaces);
+            sphereRenderer.drawDepth(pointShadowProgram, CULL_LIGHT2);
 
             // Space station
-            glUniformMatrix4fv(uModel_PL, 1, GL_FALSE, glm::value_ptr(station->getGlobalTransform()));
-            glBindVertexArray(stationVAO);
-            glDrawElements(GL_TRIANGLES, (GLsizei)stationIndices.size(), GL_UNSIGNED_INT, 0);
+            int stationFaces = cubeFaceMask(scene.bounds(station));
+            if (frameCull[CULL_LIGHT2].count(stationFaces != 0)) {
+                glUniform1i(uFaceMask_PL, stationFaces);
+                glUniformMatrix4fv(uModel_PL, 1, GL_FALSE, glm::value_ptr(scene.world(station)));
+                meshCache.bindDepthOnly(); // position stream only
+                stationMesh.draw(stationLod);
+            }
 
             if (!renderGalaxy) {
-                glm::mat4 M = glm::mat4(1.0f);
-                glUniformMatrix4fv(uModel_PL,1,GL_FALSE,glm::value_ptr(M));
-                glBindVertexArray(groundVAO);
-                glDrawElements(GL_TRIANGLES,6,GL_UNSIGNED_INT,0);
-                glBindVertexArray(0);
+                int groundFaces = cubeFaceMask(groundBounds);
+                if (frameCull[CULL_LIGHT2].count(groundFaces != 0)) {
+                    glm::mat4 M = glm::mat4(1.0f);
+                    glUniform1i(uFaceMask_PL, groundFaces);
+                    glUniformMatrix4fv(uModel_PL,1,GL_FALSE,glm::value_ptr(M));
+                    glBindVertexArray(groundVAO);
+                    glDrawElements(GL_TRIANGLES,6,GL_UNSIGNED_INT,0);
+                    glBindVertexArray(0);
+                }
             }
-        }
 
-        glBindVertexArray(0);
-        glCullFace(GL_BACK);
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        glEnable(GL_CULL_FACE); //restore culling
+            glBindVertexArray(0);
+            glCullFace(GL_BACK);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glEnable(GL_CULL_FACE); //restore culling
+        } else {
+            glCullFace(GL_BACK);
+        }
 
         // Reset viewport to window size
         int fbW, fbH; 
@@ -1304,12 +1265,12 @@ int main() {
         glViewport(0, 0, fbW, fbH);
         glUseProgram(sceneProgram);
 
-        // light 1 (directional/spot) shadow matrix
-        glUniformMatrix4fv(uLightSpace, 1, GL_FALSE, glm::value_ptr(lightSpaceMatrix));
+        // light 1 (directional) shadow cascades
+        cascades1.setUniforms(sceneProgram);
 
         // shadow textures (sampler units already fixed once)
         glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, depthTex);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, cascades1.texture());
 
         glActiveTexture(GL_TEXTURE2);
         glBindTexture(GL_TEXTURE_CUBE_MAP, depthCubeTex);
@@ -1317,6 +1278,10 @@ int main() {
         // far plane
         glUniform1f(uFarPlane2, farPL);
 
+        // PCF kernels of this tier
+        glUniform1i(uPcfTaps1, shadowTier.pcfTaps1);
+        glUniform1i(uPcfTaps2, shadowTier.pcfTaps2);
+
         // Draw the trail of the shooting star
         glUniform1i(uUseLighting, 0);
         glUniform1i(uUseTexture,  0);
@@ -1326,42 +1291,6 @@ int main() {
         glBindVertexArray(trailVAO);
         glDrawArrays(GL_LINE_STRIP, 0, (GLsizei)trailPositions.size());
 
-        // Draw galaxy background (inside-out sphere, front face culling)
-        if (renderGalaxy) {
-            int fbw = 0, fbh = 0;
-            glfwGetFramebufferSize(window, &fbw, &fbh);
-
-            glm::mat4 view = camera.getViewMatrix();
-            glm::mat4 proj = glm::perspective(glm::radians(45.0f),  (float)fbw / (float)fbh, 0.1f, 200.0f);
-
-            glUseProgram(sceneProgram);
-            glUniformMatrix4fv(uView, 1, GL_FALSE, glm::value_ptr(view));
-            glUniformMatrix4fv(uProj, 1, GL_FALSE, glm::value_ptr(proj));
-
-            glm::vec3 camPos = camera.getPosition();
-            glUniform3f(uViewPos, camPos.x, camPos.y, camPos.z);
-
-            glm::mat4 galaxyTransform = glm::scale(glm::translate(glm::mat4(1.0f), camPos), glm::vec3(50.0f));
-
-            glDisable(GL_DEPTH_TEST);
-            glCullFace(GL_FRONT);
-
-            glUniform1i(uUseLighting, 0);
-            glUniform1i(uUseTexture,  1);
-            glUniform1i(uReceiveShadows, 0);
-            glUniformMatrix4fv(uModel, 1, GL_FALSE, glm::value_ptr(galaxyTransform));
-
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, galaxyTexture);
-
-            glBindVertexArray(sphereVAO);
-            glDrawElements(GL_TRIANGLES, (GLsizei)sphereIndices.size(), GL_UNSIGNED_INT, 0);
-            glBindVertexArray(0);
-
-            glEnable(GL_DEPTH_TEST);
-            glCullFace(GL_BACK);
-        }
-        
         // Draw orbit lines
         glUseProgram(sceneProgram);
         glUniform1i(uUseLighting, 0);
@@ -1384,7 +1313,7 @@ int main() {
         glDrawArrays(GL_LINE_LOOP, 0, planetBOrbitVertices.size());
 
         // Moon orbit (orange)
-        glm::mat4 moonOrbitLineM = planetA_orbit->localTransform;
+        glm::mat4 moonOrbitLineM = scene.local(planetA_orbit);
         glBindVertexArray(moonOrbitVAO);
         glUniform3f(uObjectColor, 1.0f, 0.5f, 0.0f);
         glUniformMatrix4fv(uModel, 1, GL_FALSE, glm::value_ptr(moonOrbitLineM));
@@ -1398,8 +1327,28 @@ int main() {
         //reset object color to white for next draw calls
         glUniform3f(uObjectColor, 1.0f, 1.0f, 1.0f);
 
-        // Draw the scene recursively, instead of draw sphere one by one, use root
-        root->draw(glm::mat4(1.0f));
+        // Sun, planets, moon and shooting star: one instanced draw per LOD in use
+        sphereRenderer.draw(sceneProgram);
+
+        // Draw list: station and virtual-textured planets in view, with this frame's world matrices
+        scene.forEachVisible(passFrustums[CULL_CAMERA], &frameCull[CULL_CAMERA],
+                             [&](uint32_t kind, const glm::mat4& model) { drawFuncs[kind](model); });
+        for (int p = 0; p < CULL_PASSES; ++p)
+            cullTotals[p] += frameCull[p];
+        ++cullFrames;
+
+        // Asteroid belt: one instanced draw per LOD, whatever the asteroid count
+        glUseProgram(asteroidProgram);
+        glUniform3fv(uAstLightPos1,   1, glm::value_ptr(lightPos1));
+        glUniform3fv(uAstLightColor1, 1, glm::value_ptr(lightColor1));
+        glUniform3fv(uAstLightPos2,   1, glm::value_ptr(lightPos2));
+        glUniform3fv(uAstLightColor2, 1, glm::value_ptr(lightColor2));
+        asteroidBelt.draw(simDays, view, projection);
+        glUseProgram(sceneProgram);
+
+        // Galaxy background last: only pixels the scene left at the far plane are shaded
+        if (renderGalaxy)
+            skybox.draw(view, projection);
 
         if (appMode == gameMode::GAME) {
             // Draw crosshair: small red cross at window center (screen-space)
@@ -1458,11 +1407,11 @@ int main() {
                 glm::vec3 ro = camera.getPosition();
                 glm::vec3 rd = glm::normalize(camera.getFront());
 
-                glm::vec3 cSun     = extractTranslation(sun->getGlobalTransform());
-                glm::vec3 cEarth   = extractTranslation(planetA_orbit->getGlobalTransform() * planetA_body->localTransform);
-                glm::vec3 cMars    = extractTranslation(planetB->getGlobalTransform());
-                glm::vec3 cMoon    = extractTranslation(moon->getGlobalTransform(planetA_orbit->getGlobalTransform()));
-                glm::vec3 cStation = extractTranslation(station->getGlobalTransform());
+                glm::vec3 cSun     = extractTranslation(scene.world(sun));
+                glm::vec3 cEarth   = extractTranslation(scene.world(planetA_body));
+                glm::vec3 cMars    = extractTranslation(scene.world(planetB));
+                glm::vec3 cMoon    = extractTranslation(scene.world(moon));
+                glm::vec3 cStation = extractTranslation(scene.world(station));
 
                 int gained = 0;
                 if (rayHitsSphere(ro, rd, cSun, R_SUN))         gained += SCORE_SUN;
@@ -1583,27 +1532,10 @@ int main() {
             glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
             camera.resetMouse(); 
 
-            // Background galaxy
-            glm::mat4 galaxyTransform =
-                glm::scale(glm::translate(glm::mat4(1.0f), camera.getPosition()), glm::vec3(50.0f));
-
-            glDisable(GL_DEPTH_TEST);
-            glCullFace(GL_FRONT);
-
-            glUseProgram(sceneProgram);
-            glUniform1i(uUseLighting, 0);
-            glUniform1i(uUseTexture,  1);
-            glUniformMatrix4fv(uModel, 1, GL_FALSE, glm::value_ptr(galaxyTransform));
-
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, galaxyTexture);
-
-            glBindVertexArray(sphereVAO);
-            glDrawElements(GL_TRIANGLES, (GLsizei)sphereIndices.size(), GL_UNSIGNED_INT, 0);
-            glBindVertexArray(0);
-
-            glEnable(GL_DEPTH_TEST);
-            glCullFace(GL_BACK);
+            // Background galaxy over the whole frame: dropping the depth
+            // buffer lets it cover the scene drawn above, as before
+            glClear(GL_DEPTH_BUFFER_BIT);
+            skybox.draw(camera.getViewMatrix(), projection);
 
             // Centered UI
             int fbw=0, fbh=0; glfwGetFramebufferSize(window, &fbw, &fbh);
@@ -1684,12 +1616,46 @@ int main() {
             glfwSetWindowShouldClose(window, true);
         }
 
+        // GPU time of the frame, a few frames late, for the auto shadow tier
+        gpuFrameTimer.end();
+        float gpuMs;
+        while (gpuFrameTimer.result(gpuMs))
+            shadowSettings.frameTime(gpuMs);
+
         // Swap buffers and poll events
         glfwSwapBuffers(window);
     }
 
     // Clean-up
-    deleteSceneGraph(root);
+    meshCache.release();
+    printTextureStats();
+    printCullStats();
+    for (int c = 0; c < cascades1.cascadeCount; ++c) {
+        const ShadowCache::Stats& sc = cascades1.cache(c).stats();
+        std::cout << "Light 1 shadow cascade " << c << ": " << sc.frames << " frames, " << sc.skipped << " skipped, "
+                  << sc.dynamicOnly << " dynamic casters only, " << sc.full << " full redraws" << std::endl;
+    }
+    cascades1.release();
+    std::cout << "Shadows: " << shadowSettings.settings().name << (shadowSettings.isAuto() ? " (auto)" : "") << std::endl;
+    gpuFrameTimer.release();
+    sunTexture.reset();
+    earthTexture.reset();
+    marsTexture.reset();
+    moonTexture.reset();
+    galaxyTexture.reset();
+    textureCache.release();
+    skybox.release();
+    sphereRenderer.release();
+    asteroidBelt.release();
+    textureLoader.shutdown();
+    for (VirtualTexture* vt : { &earthVT, &marsVT, &moonVT }) {
+        if (vt->isOpen()) {
+            VirtualTexture::Stats st = vt->stats();
+            std::cout << "Virtual texture: " << st.streamed << " pages streamed, " << st.evicted << " evicted, "
+                      << st.dropped << " dropped, " << st.resident << " resident at exit" << std::endl;
+        }
+        vt->release();
+    }
 
     if (laserVBO) glDeleteBuffers(1, &laserVBO);
     if (laserVAO) glDeleteVertexArrays(1, &laserVAO);
@@ -0,0 +1,141 @@
+// textureBake.cpp
+// Bakes images into "<image>.ktx": full mip chain, BC1 for opaque images,
+// BC3 when any texel has alpha < 255. TextureLoader picks these up at runtime.
+// With -p it writes "<image>.pages" instead: the same levels cut into
+// bordered pages for VirtualTexture (meant for the 16k planet maps).
+// Build from the project root:
+//   g++ -O2 -std=c++17 tools/textureBake.cpp -o textureBake
+// Run: ./textureBake [-f] [-p] [image ...]   (default: the textures main() loads)
+//   -f  rebake even when the output is newer than the image
+//   -p  page files (default: the planet maps)
+#define STB_IMAGE_IMPLEMENTATION
+#include "../stb/stb_image.h"
+#include "../src/BlockCompress.h"
+#include "../src/PageFile.h"
+#include "../src/TextureFile.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// RGBA8 level 0, flipped like the stb path in TextureLoader.
+static bool loadImage(const char* path, std::vector<uint8_t>& level, int& w, int& h, int& channels, bool& alpha) {
+    stbi_set_flip_vertically_on_load(1);
+    unsigned char* pixels = stbi_load(path, &w, &h, &channels, 4);
+    if (!pixels) {
+        fprintf(stderr, "%s: %s\n", path, stbi_failure_reason());
+        return false;
+    }
+    level.assign(pixels, pixels + (size_t)w * h * 4);
+    stbi_image_free(pixels);
+
+    alpha = false;
+    for (size_t i = 3; i < level.size() && !alpha; i += 4) alpha = level[i] != 255;
+    return true;
+}
+
+static bool bake(const char* path, bool force) {
+    std::string out = bakedTexturePath(path);
+    if (!force && bakedTextureIsCurrent(out.c_str(), path)) {
+        printf("%s: up to date\n", out.c_str());
+        return true;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<uint8_t> level;
+    int w = 0, h = 0, channels = 0;
+    bool alpha = false;
+    if (!loadImage(path, level, w, h, channels, alpha))
+        return false;
+    uint32_t format = alpha ? KTX_COMPRESSED_RGBA_S3TC_DXT5 : KTX_COMPRESSED_RGB_S3TC_DXT1;
+
+    std::vector<std::vector<uint8_t>> levels;
+    int lw = w, lh = h;
+    size_t compressedBytes = 0;
+    for (;;) {
+        levels.push_back(compressLevel(level.data(), lw, lh, alpha));
+        compressedBytes += levels.back().size();
+        if (lw == 1 && lh == 1) break;
+        int nw, nh;
+        level = downsampleRGBA(level, lw, lh, nw, nh);
+        lw = nw;
+        lh = nh;
+    }
+
+    if (!writeTextureFile(out.c_str(), format, (uint32_t)w, (uint32_t)h, levels)) {
+        fprintf(stderr, "%s: cannot write\n", out.c_str());
+        return false;
+    }
+    // uncompressed upload + glGenerateMipmap costs ~4/3 of the base level
+    double rawBytes = (double)w * h * (channels == 4 ? 4 : 3) * 4.0 / 3.0;
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    printf("%s: %dx%d %s, %zu levels, %.1f KB (was %.1f KB as %s + mips), %.0f ms\n",
+           out.c_str(), w, h, alpha ? "BC3" : "BC1", levels.size(), compressedBytes / 1024.0,
+           rawBytes / 1024.0, channels == 4 ? "RGBA8" : "RGB8", ms);
+    return true;
+}
+
+static bool bakePages(const char* path, bool force) {
+    std::string out = pageFilePath(path);
+    if (!force && bakedTextureIsCurrent(out.c_str(), path)) {
+        printf("%s: up to date\n", out.c_str());
+        return true;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<uint8_t> level;
+    int w = 0, h = 0, channels = 0;
+    bool alpha = false;
+    if (!loadImage(path, level, w, h, channels, alpha))
+        return false;
+    uint32_t format = alpha ? KTX_COMPRESSED_RGBA_S3TC_DXT5 : KTX_COMPRESSED_RGB_S3TC_DXT1;
+
+    std::vector<PageLevel> levels = pageLevelsFor((uint32_t)w, (uint32_t)h);
+    std::vector<std::vector<uint8_t>> pages(levels.size());
+    std::vector<uint8_t> page((size_t)PAGE_SIZE * PAGE_SIZE * 4);
+    size_t pageCount = 0;
+    for (size_t i = 0; i < levels.size(); ++i) {
+        const PageLevel& l = levels[i];
+        for (uint32_t ty = 0; ty < l.tilesY; ++ty)
+            for (uint32_t tx = 0; tx < l.tilesX; ++tx) {
+                extractPage(level.data(), l.width, l.height, tx, ty, page.data());
+                std::vector<uint8_t> blocks = compressLevel(page.data(), PAGE_SIZE, PAGE_SIZE, alpha);
+                pages[i].insert(pages[i].end(), blocks.begin(), blocks.end());
+                ++pageCount;
+            }
+        if (i + 1 < levels.size()) {
+            int nw, nh;
+            level = downsampleRGBA(level, (int)l.width, (int)l.height, nw, nh);
+        }
+    }
+
+    if (!writePageFile(out.c_str(), format, (uint32_t)w, (uint32_t)h, pages)) {
+        fprintf(stderr, "%s: cannot write\n", out.c_str());
+        return false;
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    printf("%s: %dx%d %s, %zu levels, %zu pages of %ux%u, %.1f MB, %.0f ms\n",
+           out.c_str(), w, h, alpha ? "BC3" : "BC1", levels.size(), pageCount, PAGE_SIZE, PAGE_SIZE,
+           pageCount * (double)pageBytesFor(format) / (1024.0 * 1024.0), ms);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    bool force = false, pages = false;
+    std::vector<const char*> files;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-f") == 0) force = true;
+        else if (strcmp(argv[i], "-p") == 0) pages = true;
+        else files.push_back(argv[i]);
+    }
+    if (files.empty() && pages)
+        files = { "texture/earth.jpg", "texture/mars.jpg", "texture/moon.jpg" };
+    else if (files.empty())
+        files = { "texture/sun.jpg", "texture/earth.jpg", "texture/mars.jpg",
+                  "texture/moon.jpg", "texture/galaxy.jpg" };
+
+    int failed = 0;
+    for (const char* f : files)
+        if (!(pages ? bakePages(f, force) : bake(f, force))) ++failed;
+    return failed ? 1 : 0;
+}